@@ -0,0 +1,330 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench_shim.h"
+
+#include "actions_manager.h"
+#include "actions_propagate.h"
+#include "actions_processor.h"
+#include "actions_batch.h"
+
+/*
+ * Hot path micro benchmarks, run outside of server against the same sources extension is built from.
+ * Population matches a full versus/coop round: 8 survivor bots plus 100 common infected.
+ */
+
+static constexpr cell_t SURVIVORS = 8;
+static constexpr cell_t INFECTED = 100;
+static constexpr cell_t POPULATION = SURVIVORS + INFECTED;
+static constexpr cell_t FIRST_ENTITY = 1;
+
+/* Depth of behavior stack every bot carries */
+static constexpr size_t STACK_DEPTH = 4;
+
+static const char* s_survivorActions[STACK_DEPTH] = { "SurvivorBehavior", "SurvivorLegsMoveOn", "SurvivorLegsBattleStations", "SurvivorAttack" };
+static const char* s_infectedActions[STACK_DEPTH] = { "InfectedBehavior", "InfectedWander", "InfectedAttack", "InfectedStandingActivity" };
+
+/* Every class gets its own vtable, same as game actions */
+template<bool survivor, size_t depth>
+class BenchAction : public Action<void>
+{
+public:
+	virtual const char* GetName() const override
+	{
+		return survivor ? s_survivorActions[depth] : s_infectedActions[depth];
+	}
+};
+
+static Action<void>* CreateAction(bool survivor, size_t depth, CBaseEntity* actor)
+{
+	Action<void>* action = NULL;
+
+	switch (depth)
+	{
+		case 0: action = survivor ? (Action<void>*)new BenchAction<true, 0>() : new BenchAction<false, 0>(); break;
+		case 1: action = survivor ? (Action<void>*)new BenchAction<true, 1>() : new BenchAction<false, 1>(); break;
+		case 2: action = survivor ? (Action<void>*)new BenchAction<true, 2>() : new BenchAction<false, 2>(); break;
+		default: action = survivor ? (Action<void>*)new BenchAction<true, 3>() : new BenchAction<false, 3>(); break;
+	}
+
+	action->m_actor = actor;
+	return action;
+}
+
+struct Bot
+{
+	cell_t entity;
+	CBaseEntity* actor;
+	bool survivor;
+	Action<void>* stack[STACK_DEPTH];
+};
+
+static std::vector<Bot> CreatePopulation()
+{
+	std::vector<Bot> bots(POPULATION);
+
+	for (cell_t i = 0; i < POPULATION; i++)
+	{
+		Bot& bot = bots[i];
+		bot.entity = FIRST_ENTITY + i;
+		bot.actor = BenchEntity(bot.entity);
+		bot.survivor = i < SURVIVORS;
+
+		for (size_t depth = 0; depth < STACK_DEPTH; depth++)
+			bot.stack[depth] = CreateAction(bot.survivor, depth, bot.actor);
+	}
+
+	return bots;
+}
+
+static void DestroyPopulation(std::vector<Bot>& bots)
+{
+	for (Bot& bot : bots)
+	{
+		for (Action<void>* action : bot.stack)
+		{
+			g_pActionsManager->Remove(action);
+			delete action;
+		}
+	}
+
+	bots.clear();
+}
+
+using Clock = std::chrono::steady_clock;
+
+static void Report(const char* name, Clock::duration elapsed, uint64_t ops)
+{
+	const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+	printf("%-44s %12llu ops %10.2f ns/op\n", name, (unsigned long long)ops, ops != 0 ? ns / ops : 0.0);
+}
+
+static void BenchAddRemove(size_t iterations)
+{
+	std::vector<Bot> bots = CreatePopulation();
+	uint64_t ops = 0;
+
+	Clock::time_point start = Clock::now();
+
+	for (size_t i = 0; i < iterations; i++)
+	{
+		for (Bot& bot : bots)
+		{
+			for (Action<void>* action : bot.stack)
+				g_pActionsManager->Add(bot.entity, action);
+		}
+
+		for (Bot& bot : bots)
+		{
+			for (Action<void>* action : bot.stack)
+				g_pActionsManager->Remove(bot.entity, action);
+		}
+
+		ops += POPULATION * STACK_DEPTH * 2;
+	}
+
+	Report("ActionsManager::Add + Remove", Clock::now() - start, ops);
+	DestroyPopulation(bots);
+}
+
+static void BenchIsValidAction(size_t iterations)
+{
+	std::vector<Bot> bots = CreatePopulation();
+
+	for (Bot& bot : bots)
+	{
+		for (Action<void>* action : bot.stack)
+			g_pActionsManager->Add(bot.entity, action);
+	}
+
+	/* Plugins pass stale addresses too, half of lookups miss */
+	std::vector<Action<void>*> stale;
+
+	for (cell_t i = 0; i < POPULATION * (cell_t)STACK_DEPTH; i++)
+		stale.push_back(reinterpret_cast<Action<void>*>(static_cast<uintptr_t>(0x10000 + i * 64)));
+
+	uint64_t ops = 0, valid = 0;
+	Clock::time_point start = Clock::now();
+
+	for (size_t i = 0; i < iterations; i++)
+	{
+		for (Bot& bot : bots)
+		{
+			for (Action<void>* action : bot.stack)
+				valid += g_pActionsManager->IsValidAction(action);
+		}
+
+		for (Action<void>* action : stale)
+			valid += g_pActionsManager->IsValidAction(action);
+
+		ops += POPULATION * STACK_DEPTH * 2;
+	}
+
+	Report("ActionsManager::IsValidAction", Clock::now() - start, ops);
+
+	if (valid != ops / 2)
+		fprintf(stderr, "IsValidAction: expected %llu valid, got %llu\n", (unsigned long long)(ops / 2), (unsigned long long)valid);
+
+	DestroyPopulation(bots);
+}
+
+/* Goes through HandlerProcessor exactly like SourceHook would, so probes and result checks are included */
+static void BenchProcessHandler(size_t iterations, size_t listenersCount, float interval = 0.0f)
+{
+	using Sight = decltype(ActionProcessor::sight);
+
+	std::vector<Bot> bots = CreatePopulation();
+	std::vector<BenchListener> listeners(listenersCount);
+
+	for (Bot& bot : bots)
+	{
+		for (Action<void>* action : bot.stack)
+			ActionProcessor processor(bot.actor, action);
+
+		for (BenchListener& listener : listeners)
+			g_pActionsPropagatePre->AddListener(Sight::vtableindex, bot.stack[STACK_DEPTH - 1], &listener, 0, interval);
+	}
+
+	CBaseEntity* subject = BenchEntity(FIRST_ENTITY + POPULATION);
+	uint64_t ops = 0;
+
+	Clock::time_point start = Clock::now();
+
+	for (size_t i = 0; i < iterations; i++)
+	{
+		for (Bot& bot : bots)
+		{
+			g_pBenchIfacePtr = bot.stack[STACK_DEPTH - 1];
+			Sight::Process(bot.actor, subject);
+		}
+
+		/* 30 tick server */
+		g_BenchGlobals.curtime += 1.0f / 30.0f;
+		ops += POPULATION;
+	}
+
+	char name[64];
+
+	if (interval > 0.0f)
+		snprintf(name, sizeof(name), "ProcessHandler OnSight, %zu listener(s) / %.1fs", listenersCount, interval);
+	else
+		snprintf(name, sizeof(name), "ProcessHandler OnSight, %zu listener(s)", listenersCount);
+
+	Report(name, Clock::now() - start, ops);
+
+	uint64_t calls = 0;
+
+	for (BenchListener& listener : listeners)
+		calls += listener.GetCalls();
+
+	if (interval == 0.0f && calls != ops * listenersCount)
+		fprintf(stderr, "ProcessHandler: expected %llu callbacks, got %llu\n", (unsigned long long)(ops * listenersCount), (unsigned long long)calls);
+
+	g_pBenchIfacePtr = NULL;
+	DestroyPopulation(bots);
+}
+
+/* Post observers of whole population, per event listener against one batch delivered every frame */
+static void BenchBatch(size_t iterations, bool batched)
+{
+	using Sight = decltype(ActionProcessor::sight);
+
+	std::vector<Bot> bots = CreatePopulation();
+	BenchListener listener;
+
+	for (Bot& bot : bots)
+	{
+		for (Action<void>* action : bot.stack)
+			ActionProcessor processor(bot.actor, action);
+
+		if (!batched)
+			g_pActionsPropagatePost->AddListener(Sight::vtableindex, bot.stack[STACK_DEPTH - 1], &listener);
+	}
+
+	if (batched)
+		g_pActionsBatch->AddListener("OnSight", &listener);
+
+	CBaseEntity* subject = BenchEntity(FIRST_ENTITY + POPULATION);
+	uint64_t ops = 0;
+
+	Clock::time_point start = Clock::now();
+
+	for (size_t i = 0; i < iterations; i++)
+	{
+		for (Bot& bot : bots)
+		{
+			g_pBenchIfacePtr = bot.stack[STACK_DEPTH - 1];
+			Sight::ProcessPost(bot.actor, subject);
+		}
+
+		ActionsBatch::OnGameFrame(true);
+		ops += POPULATION;
+	}
+
+	Report(batched ? "OnSight post, batched observer" : "OnSight post, per event observer", Clock::now() - start, ops);
+
+	uint64_t expected = batched ? iterations : ops;
+
+	if (listener.GetCalls() != expected)
+		fprintf(stderr, "Batch: expected %llu callbacks, got %llu\n", (unsigned long long)expected, (unsigned long long)listener.GetCalls());
+
+	if (batched)
+		g_pActionsBatch->RemoveListener("OnSight", &listener);
+
+	g_pBenchIfacePtr = NULL;
+	DestroyPopulation(bots);
+}
+
+static void BenchActionProcessor(size_t iterations)
+{
+	uint64_t ops = 0;
+	Clock::duration elapsed = Clock::duration::zero();
+
+	for (size_t i = 0; i < iterations; i++)
+	{
+		std::vector<Bot> bots = CreatePopulation();
+		Clock::time_point start = Clock::now();
+
+		for (Bot& bot : bots)
+		{
+			for (Action<void>* action : bot.stack)
+				ActionProcessor processor(bot.actor, action);
+		}
+
+		elapsed += Clock::now() - start;
+		ops += POPULATION * STACK_DEPTH;
+
+		DestroyPopulation(bots);
+	}
+
+	Report("ActionProcessor construction", elapsed, ops);
+	printf("%-44s %12zu\n", "Hooks installed", BenchActiveHooks());
+}
+
+int main(int argc, char** argv)
+{
+	size_t iterations = 2000;
+
+	if (argc > 1)
+		iterations = strtoul(argv[1], NULL, 10);
+
+	if (iterations == 0)
+		iterations = 1;
+
+	ReconfigureHooks();
+
+	printf("Population: %i survivors, %i infected, %zu actions each, %zu iterations\n", SURVIVORS, INFECTED, STACK_DEPTH, iterations);
+
+	BenchAddRemove(iterations);
+	BenchIsValidAction(iterations);
+	BenchProcessHandler(iterations, 0);
+	BenchProcessHandler(iterations, 1);
+	BenchProcessHandler(iterations, 8);
+	BenchProcessHandler(iterations, 8, 0.3f);
+	BenchBatch(iterations, false);
+	BenchBatch(iterations, true);
+	BenchActionProcessor(iterations / 10 + 1);
+	return 0;
+}
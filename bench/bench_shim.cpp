@@ -0,0 +1,208 @@
+#include <cstdarg>
+
+#include "bench_shim.h"
+
+/* Entities are addresses inside this block, so entity <-> index is pointer math like in edict list */
+static char s_entities[ActionsManager::MAX_ENTITIES];
+
+const Vector vec3_origin(0.0f, 0.0f, 0.0f);
+
+CGlobalVars g_BenchGlobals = {};
+CGlobalVars* gpGlobals = &g_BenchGlobals;
+
+IGameConfig* g_pGameConf = NULL;
+ICvar* icvar = NULL;
+void* g_pBenchIfacePtr = NULL;
+
+static size_t s_hooks = 0;
+static int s_lastHookId = 0;
+
+int BenchAddHook(void* vtable, const void* handler, bool post)
+{
+	s_hooks++;
+	return ++s_lastHookId;
+}
+
+bool BenchRemoveHook(int id)
+{
+	if (s_hooks > 0)
+		s_hooks--;
+
+	return id != 0;
+}
+
+size_t BenchActiveHooks()
+{
+	return s_hooks;
+}
+
+CBaseEntity* BenchEntity(cell_t index)
+{
+	return reinterpret_cast<CBaseEntity*>(&s_entities[index]);
+}
+
+class BenchGameHelpers : public IGameHelpers
+{
+public:
+	virtual cell_t EntityToBCompatRef(CBaseEntity* entity) override
+	{
+		const char* address = reinterpret_cast<const char*>(entity);
+
+		if (address < s_entities || address >= s_entities + sizeof(s_entities))
+			return -1;
+
+		return static_cast<cell_t>(address - s_entities);
+	}
+
+	virtual CBaseEntity* ReferenceToEntity(cell_t entRef) override
+	{
+		if (entRef < 0 || entRef >= ActionsManager::MAX_ENTITIES)
+			return NULL;
+
+		return BenchEntity(entRef);
+	}
+
+	virtual cell_t EntityToReference(CBaseEntity* entity) override
+	{
+		return EntityToBCompatRef(entity);
+	}
+
+	virtual int ReferenceToIndex(cell_t entRef) override
+	{
+		return entRef;
+	}
+} s_gameHelpers;
+
+/* No plugin ever subscribes to global forwards, extension only pays for GetFunctionCount */
+class BenchForward : public IForward
+{
+public:
+	virtual int PushCell(cell_t cell) override { return 0; }
+	virtual int PushCellByRef(cell_t* cell, int flags) override { return 0; }
+	virtual int PushFloat(float number) override { return 0; }
+	virtual int PushFloatByRef(float* number, int flags) override { return 0; }
+	virtual int PushArray(cell_t* inarray, unsigned int cells, int flags) override { return 0; }
+	virtual int PushString(const char* string) override { return 0; }
+	virtual int PushStringEx(char* buffer, size_t length, int sz_flags, int cp_flags) override { return 0; }
+	virtual void Cancel() override {}
+
+	virtual int Execute(cell_t* result, void* filter) override { return 0; }
+	virtual unsigned int GetFunctionCount() override { return 0; }
+} s_forward;
+
+class BenchForwardManager : public IForwardManager
+{
+public:
+	virtual IForward* CreateForward(const char* name, ExecType et, unsigned int num_params, const ParamType* types, ...) override
+	{
+		return &s_forward;
+	}
+} s_forwards;
+
+class BenchPlugin : public IPlugin
+{
+public:
+	virtual const char* GetFilename() override
+	{
+		return "bench.smx";
+	}
+} s_plugin;
+
+class BenchPluginManager : public IPluginManager
+{
+public:
+	virtual IPlugin* FindPluginByContext(void* ctx) override
+	{
+		return &s_plugin;
+	}
+} s_plugins;
+
+class BenchSourceMod : public ISourceMod
+{
+public:
+	virtual void LogMessage(IExtension* ext, const char* msg, ...) override
+	{
+		va_list ap;
+		va_start(ap, msg);
+		vprintf(msg, ap);
+		va_end(ap);
+		printf("\n");
+	}
+
+	virtual void LogError(IExtension* ext, const char* msg, ...) override
+	{
+		va_list ap;
+		va_start(ap, msg);
+		vfprintf(stderr, msg, ap);
+		va_end(ap);
+		fprintf(stderr, "\n");
+	}
+
+	virtual size_t BuildPath(PathType type, char* buffer, size_t maxlength, const char* format, ...) override
+	{
+		va_list ap;
+		va_start(ap, format);
+		int length = vsnprintf(buffer, maxlength, format, ap);
+		va_end(ap);
+		return length < 0 ? 0 : (size_t)length;
+	}
+} s_sourcemod;
+
+IGameHelpers* gamehelpers = &s_gameHelpers;
+IForwardManager* forwards = &s_forwards;
+IPluginManager* plsys = &s_plugins;
+ISourceMod* g_pSM = &s_sourcemod;
+ISourceMod* smutils = &s_sourcemod;
+IExtension* myself = NULL;
+
+/* Behaves like a plugin callback that returns Plugin_Continue */
+class BenchContext : public IPluginContext
+{
+public:
+	virtual int ReportError(const char* message, ...) override
+	{
+		return 0;
+	}
+
+	virtual void* GetContext() override
+	{
+		return this;
+	}
+};
+
+class BenchRuntime : public IPluginRuntime
+{
+public:
+	virtual IPluginContext* GetDefaultContext() override
+	{
+		return &m_context;
+	}
+
+private:
+	BenchContext m_context;
+} s_runtime;
+
+int BenchListener::PushCell(cell_t cell) { m_pushed++; return 0; }
+int BenchListener::PushCellByRef(cell_t* cell, int flags) { m_pushed++; return 0; }
+int BenchListener::PushFloat(float number) { m_pushed++; return 0; }
+int BenchListener::PushFloatByRef(float* number, int flags) { m_pushed++; return 0; }
+int BenchListener::PushArray(cell_t* inarray, unsigned int cells, int flags) { m_pushed++; return 0; }
+int BenchListener::PushString(const char* string) { m_pushed++; return 0; }
+int BenchListener::PushStringEx(char* buffer, size_t length, int sz_flags, int cp_flags) { m_pushed++; return 0; }
+void BenchListener::Cancel() { m_pushed = 0; }
+
+int BenchListener::Execute(cell_t* result)
+{
+	m_calls++;
+	m_pushed = 0;
+
+	if (result)
+		*result = Pl_Continue;
+
+	return 0;
+}
+
+IPluginRuntime* BenchListener::GetParentRuntime()
+{
+	return &s_runtime;
+}
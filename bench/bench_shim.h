@@ -0,0 +1,35 @@
+#pragma once
+
+#include "extension.h"
+#include "actions_manager.h"
+
+/* Plugin callback stand-in, counts calls so benchmarks can check listeners actually ran */
+class BenchListener : public IPluginFunction
+{
+public:
+	virtual int PushCell(cell_t cell) override;
+	virtual int PushCellByRef(cell_t* cell, int flags) override;
+	virtual int PushFloat(float number) override;
+	virtual int PushFloatByRef(float* number, int flags) override;
+	virtual int PushArray(cell_t* inarray, unsigned int cells, int flags) override;
+	virtual int PushString(const char* string) override;
+	virtual int PushStringEx(char* buffer, size_t length, int sz_flags, int cp_flags) override;
+	virtual void Cancel() override;
+
+	virtual int Execute(cell_t* result) override;
+	virtual IPluginRuntime* GetParentRuntime() override;
+
+	uint64_t GetCalls() const noexcept
+	{
+		return m_calls;
+	}
+
+private:
+	uint64_t m_calls = 0;
+	size_t m_pushed = 0;
+};
+
+extern CGlobalVars g_BenchGlobals;
+
+CBaseEntity* BenchEntity(cell_t index);
+size_t BenchActiveHooks();
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstring>
+
+template<int SIZE_BUF>
+class CFmtStrN
+{
+public:
+	CFmtStrN() { m_szBuf[0] = '\0'; }
+	operator const char*() const { return m_szBuf; }
+
+private:
+	char m_szBuf[SIZE_BUF];
+};
+
+inline char* Q_strcat(char* dest, const char* src, int maxlen)
+{
+	size_t length = strlen(dest);
+
+	if ((int)length + 1 < maxlen)
+		strncat(dest, src, maxlen - length - 1);
+
+	return dest;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+
+#define MEM_INTERFACE extern
+
+class IMemAlloc
+{
+public:
+	virtual void* Alloc(size_t size) = 0;
+	virtual void Free(void* block) = 0;
+};
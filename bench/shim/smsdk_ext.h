@@ -0,0 +1,240 @@
+#pragma once
+
+/*
+ * Minimal stand-in for SourceMod SDK used by benchmark.
+ * Declares only the parts of interfaces extension sources touch, definitions live in bench_shim.cpp.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+
+#include "smsdk_config.h"
+
+typedef int32_t cell_t;
+typedef uint32_t funcid_t;
+
+class CBaseEntity;
+class IExtension;
+class ConCommandBase;
+class ICvar;
+
+class CGlobalVars
+{
+public:
+	float realtime;
+	int framecount;
+	float absoluteframetime;
+	float curtime;
+	float frametime;
+	int maxClients;
+	int tickcount;
+	float interval_per_tick;
+};
+
+enum ResultType
+{
+	Pl_Continue = 0,
+	Pl_Changed = 1,
+	Pl_Handled = 3,
+	Pl_Stop = 4
+};
+
+enum ExecType
+{
+	ET_Ignore = 0,
+	ET_Single = 1,
+	ET_Event = 2,
+	ET_Hook = 3
+};
+
+enum ParamType
+{
+	Param_Any = 0,
+	Param_Cell = (1 << 1),
+	Param_Float = (2 << 1),
+	Param_String = (3 << 1) | 1,
+	Param_Array = (4 << 1) | 1,
+	Param_VarArgs = (5 << 1),
+	Param_CellByRef = (1 << 1) | 1,
+	Param_FloatByRef = (2 << 1) | 1
+};
+
+enum PathType
+{
+	Path_None = 0,
+	Path_Game,
+	Path_SM,
+	Path_SM_Rel
+};
+
+#define SM_PARAM_COPYBACK		(1 << 0)
+#define SM_PARAM_STRING_UTF8	(1 << 0)
+#define SM_PARAM_STRING_COPY	(1 << 1)
+#define SM_PARAM_STRING_BINARY	(1 << 2)
+
+#define PLATFORM_MAX_PATH 256
+
+class IPluginContext;
+
+class IPluginRuntime
+{
+public:
+	virtual IPluginContext* GetDefaultContext() = 0;
+};
+
+class IPluginContext
+{
+public:
+	virtual int ReportError(const char* message, ...) = 0;
+	virtual void* GetContext() = 0;
+};
+
+class ICallable
+{
+public:
+	virtual int PushCell(cell_t cell) = 0;
+	virtual int PushCellByRef(cell_t* cell, int flags = SM_PARAM_COPYBACK) = 0;
+	virtual int PushFloat(float number) = 0;
+	virtual int PushFloatByRef(float* number, int flags = SM_PARAM_COPYBACK) = 0;
+	virtual int PushArray(cell_t* inarray, unsigned int cells, int flags = 0) = 0;
+	virtual int PushString(const char* string) = 0;
+	virtual int PushStringEx(char* buffer, size_t length, int sz_flags, int cp_flags) = 0;
+	virtual void Cancel() = 0;
+};
+
+class IPluginFunction : public ICallable
+{
+public:
+	virtual int Execute(cell_t* result) = 0;
+	virtual IPluginRuntime* GetParentRuntime() = 0;
+};
+
+class IForward : public ICallable
+{
+public:
+	virtual int Execute(cell_t* result = NULL, void* filter = NULL) = 0;
+	virtual unsigned int GetFunctionCount() = 0;
+};
+
+class IChangeableForward : public IForward
+{
+};
+
+class IPlugin
+{
+public:
+	virtual const char* GetFilename() = 0;
+};
+
+class IPluginsListener
+{
+public:
+	virtual void OnPluginLoaded(IPlugin* plugin) {}
+	virtual void OnPluginUnloaded(IPlugin* plugin) {}
+};
+
+class IPluginManager
+{
+public:
+	virtual IPlugin* FindPluginByContext(void* ctx) = 0;
+};
+
+class IForwardManager
+{
+public:
+	virtual IForward* CreateForward(const char* name, ExecType et, unsigned int num_params, const ParamType* types, ...) = 0;
+};
+
+class IGameHelpers
+{
+public:
+	virtual cell_t EntityToBCompatRef(CBaseEntity* entity) = 0;
+	virtual CBaseEntity* ReferenceToEntity(cell_t entRef) = 0;
+	virtual cell_t EntityToReference(CBaseEntity* entity) = 0;
+	virtual int ReferenceToIndex(cell_t entRef) = 0;
+};
+
+class ISourceMod
+{
+public:
+	virtual void LogMessage(IExtension* ext, const char* msg, ...) = 0;
+	virtual void LogError(IExtension* ext, const char* msg, ...) = 0;
+	virtual size_t BuildPath(PathType type, char* buffer, size_t maxlength, const char* format, ...) = 0;
+};
+
+extern IGameHelpers* gamehelpers;
+extern IForwardManager* forwards;
+extern IPluginManager* plsys;
+extern ISourceMod* g_pSM;
+extern ISourceMod* smutils;
+extern IExtension* myself;
+
+inline cell_t sp_ftoc(float val)
+{
+	cell_t cell;
+	memcpy(&cell, &val, sizeof(cell));
+	return cell;
+}
+
+inline float sp_ctof(cell_t val)
+{
+	float number;
+	memcpy(&number, &val, sizeof(number));
+	return number;
+}
+
+/* Console variables keep their value only, nothing is registered */
+#define FCVAR_NONE 0
+
+class ConCommandBase
+{
+};
+
+class ConVar : public ConCommandBase
+{
+public:
+	ConVar(const char* name, const char* value, int flags = 0, const char* help = NULL, bool hasMin = false, float min = 0.0f, bool hasMax = false, float max = 0.0f) : m_name(name)
+	{
+		SetValue(value);
+	}
+
+	void SetValue(const char* value)
+	{
+		snprintf(m_string, sizeof(m_string), "%s", value);
+		m_float = (float)atof(value);
+		m_int = atoi(value);
+	}
+
+	const char* GetName() const { return m_name; }
+	const char* GetString() const { return m_string; }
+	float GetFloat() const { return m_float; }
+	int GetInt() const { return m_int; }
+	bool GetBool() const { return m_int != 0; }
+
+private:
+	const char* m_name;
+	char m_string[64];
+	float m_float;
+	int m_int;
+};
+
+class IConCommandBaseAccessor
+{
+public:
+	virtual bool RegisterConCommandBase(ConCommandBase* command) = 0;
+};
+
+class IGameConfig;
+class ISmmAPI;
+
+class SDKExtension
+{
+public:
+	virtual bool SDK_OnLoad(char* error, size_t maxlen, bool late) { return true; }
+	virtual void SDK_OnUnload() {}
+	virtual void SDK_OnAllLoaded() {}
+	virtual bool SDK_OnMetamodLoad(ISmmAPI* ismm, char* error, size_t maxlen, bool late) { return true; }
+};
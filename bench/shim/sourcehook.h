@@ -0,0 +1,45 @@
+#pragma once
+
+/*
+ * SourceHook stand-in, hooks are only counted so ActionProcessor bookkeeping runs as in game.
+ * Handlers are benchmarked by calling ActionsPropagate directly, nothing is ever detoured.
+ */
+
+enum META_RES
+{
+	MRES_IGNORED = 0,
+	MRES_HANDLED,
+	MRES_OVERRIDE,
+	MRES_SUPERCEDE
+};
+
+extern int BenchAddHook(void* vtable, const void* handler, bool post);
+extern bool BenchRemoveHook(int id);
+extern void* g_pBenchIfacePtr;
+
+template<typename T>
+inline T BenchOrigRet()
+{
+	return T();
+}
+
+#define SH_DECL_MANUALHOOK0_void(hookname, ...) struct __SH_##hookname {}
+#define SH_DECL_MANUALHOOK1_void(hookname, ...) struct __SH_##hookname {}
+#define SH_DECL_MANUALHOOK2_void(hookname, ...) struct __SH_##hookname {}
+#define SH_DECL_MANUALHOOK0(hookname, ...) struct __SH_##hookname {}
+#define SH_DECL_MANUALHOOK1(hookname, ...) struct __SH_##hookname {}
+#define SH_DECL_MANUALHOOK2(hookname, ...) struct __SH_##hookname {}
+#define SH_DECL_MANUALHOOK3(hookname, ...) struct __SH_##hookname {}
+#define SH_DECL_MANUALHOOK4(hookname, ...) struct __SH_##hookname {}
+#define SH_DECL_MANUALHOOK5(hookname, ...) struct __SH_##hookname {}
+
+#define SH_STATIC(func) ((const void*)&(func))
+#define SH_ADD_MANUALDVPHOOK(hookname, vtable, handler, post) BenchAddHook((void*)(vtable), handler, post)
+#define SH_ADD_MANUALVPHOOK(hookname, iface, handler, post) BenchAddHook(*(void**)(iface), handler, post)
+#define SH_REMOVE_HOOK_ID(id) BenchRemoveHook(id)
+#define SH_MANUALHOOK_RECONFIGURE(hookname, index, thisptr_offs, vtbl_offs) ((void)0)
+
+#define META_IFACEPTR(type) (static_cast<type*>(g_pBenchIfacePtr))
+#define META_RESULT_ORIG_RET(type) (BenchOrigRet<type>())
+#define RETURN_META(result) return
+#define RETURN_META_VALUE(result, value) return (value)
@@ -0,0 +1,15 @@
+#pragma once
+
+class Vector
+{
+public:
+	Vector() : x(0.0f), y(0.0f), z(0.0f) {}
+	Vector(float X, float Y, float Z) : x(X), y(Y), z(Z) {}
+
+	bool operator==(const Vector& other) const { return x == other.x && y == other.y && z == other.z; }
+	bool operator!=(const Vector& other) const { return !(*this == other); }
+
+	float x, y, z;
+};
+
+extern const Vector vec3_origin;
@@ -83,7 +83,7 @@ function(add_extension ext_name engine)
 		${SDK_PATH}/lib/linux/libvstdlib_srv.so)
 
 		#target_compile_options(${ext_name} PUBLIC -static-libstdc++ -stdlib=libstdc++)
-        target_link_options(${ext_name} PUBLIC -static-libstdc++ -static-libgcc)
+        target_link_options(${ext_name} PUBLIC -static-libstdc++ -static-libgcc -pthread)
 	
 	else()
 		add_compile_definitions(
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "utils.h"
+
+#include "extension.h"
+#include "actions_manager.h"
+
+#include <bitset>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include <am-hashset.h>
+
+#include "NextBotBehavior.h"
+
+/*
+ * Opt-in batched delivery of perception events to post observers.
+ * Events of every action are collected during a frame and passed to each callback in one call on next game frame,
+ * so a horde costs one VM transition per handler instead of one per event. Callbacks can't change results.
+ */
+class ActionsBatch
+{
+public:
+	static constexpr size_t SIZE = 100;
+	/* Per handler and frame, events above it are dropped */
+	static constexpr size_t MAX_EVENTS = 4096;
+
+	enum Field : size_t
+	{
+		FIELD_ACTION,
+		FIELD_ACTOR,
+		FIELD_ENTITY,	// subject, sound source or touched entity
+		FIELD_POS_X,	// sound position, 0.0 for other handlers
+		FIELD_POS_Y,
+		FIELD_POS_Z,
+
+		FIELDS
+	};
+
+public:
+	ActionsBatch();
+
+	static bool IsSupported(const char* handler);
+
+	bool AddListener(const char* handler, IPluginFunction* callback);
+	bool RemoveListener(const char* handler, IPluginFunction* callback);
+	void RemoveListeners(IPluginContext* context);
+
+	inline bool IsBatched(size_t vtableidx) const noexcept
+	{
+		return vtableidx < SIZE && m_batched.test(vtableidx);
+	}
+
+	template<typename ...Args>
+	void Append(size_t vtableidx, Action<void>* action, Args&&... args)
+	{
+		cell_t* event = Reserve(vtableidx);
+
+		if (event == NULL)
+			return;
+
+		auto i = m_queued.findForAdd(action);
+
+		if (!i.found())
+			m_queued.add(i, action);
+
+		size_t entities = 0;
+
+		event[FIELD_ACTION] = g_pActionsManager->ToCell(action);
+		event[FIELD_ACTOR] = -1;
+		event[FIELD_ENTITY] = -1;
+		event[FIELD_POS_X] = event[FIELD_POS_Y] = event[FIELD_POS_Z] = sp_ftoc(0.0f);
+
+		(Fill(event, entities, args), ...);
+	}
+
+	/* Queued records of destroyed action get INVALID_ACTION, its address may be reused before delivery */
+	void OnActionDestroyed(Action<void>* action);
+
+	/* Game frame hook, delivers and clears everything collected since previous frame */
+	static void OnGameFrame(bool simulating);
+
+private:
+	struct Batch
+	{
+		size_t vtableidx;
+		const char* handler;
+		std::vector<IPluginFunction*> callbacks;
+		std::vector<cell_t> events;
+		size_t dropped;
+	};
+
+	template<typename T>
+	static void Fill(cell_t* event, size_t& entities, T&& arg)
+	{
+		using type = std::remove_const_t<std::remove_reference_t<T>>;
+
+		if constexpr (std::is_same<type, CBaseEntity*>::value)
+		{
+			/* First entity argument is always actor */
+			cell_t index = arg != NULL ? gamehelpers->EntityToBCompatRef(arg) : -1;
+			event[entities++ == 0 ? FIELD_ACTOR : FIELD_ENTITY] = index;
+		}
+		else if constexpr (std::is_same<type, Vector>::value)
+		{
+			memcpy(&event[FIELD_POS_X], &arg, sizeof(cell_t) * 3);
+		}
+	}
+
+	cell_t* Reserve(size_t vtableidx);
+	Batch* Find(size_t vtableidx);
+	void Deliver();
+
+private:
+	std::vector<Batch> m_batches;
+	std::bitset<SIZE> m_batched;
+	/* Actions with records queued since last delivery, others are destroyed without scanning batches */
+	ke::HashSet<Action<void>*, ke::PointerPolicy<Action<void>>> m_queued;
+};
+
+extern ActionsBatch* g_pActionsBatch;
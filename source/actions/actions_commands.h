@@ -108,6 +108,133 @@ CON_COMMAND(ext_actions_offsets, "Dump extension functions offset")
     }
 }
 
+CON_COMMAND(ext_actions_memory, "Prints memory used by actions storage")
+{
+    ActionsManager::MemoryUsage usage;
+    g_pActionsManager->GetMemoryUsage(usage);
+
+    LOG("Entity slots: %i x %i bytes (%i inline actions per slot)", ActionsManager::MAX_ENTITIES, sizeof(ActionsManager::ActionsQueque), ActionsManager::INLINE_ACTIONS);
+    LOG("Slot table: %i bytes", usage.table);
+    LOG("Spilled slots: %i bytes", usage.spilled);
+    LOG("Owners index: %i bytes", usage.owners);
+    LOG("Pending actions: %i bytes", usage.pending);
+    LOG("Handles: %i bytes", usage.handles);
+    LOG("User data: %i bytes", usage.userdata);
+    LOG("Total: %i bytes for %i actions on %i entities", usage.table + usage.spilled + usage.owners + usage.pending + usage.handles + usage.userdata, usage.actions, usage.entities);
+}
+
+CON_COMMAND(ext_actions_pool, "Prints custom actions pool stats. Usage: ext_actions_pool [flush]")
+{
+    if (args.ArgC() > 1 && strcmp(args[1], "flush") == 0)
+    {
+        g_pActionsPool->Flush();
+        LOG("Actions pool flushed");
+        return;
+    }
+
+    g_pActionsPool->Report();
+}
+
+CON_COMMAND(ext_actions_pending, "Lists created but never started actions")
+{
+    g_pActionsManager->ReportPending();
+}
+
+CON_COMMAND(ext_actions_census, "Prints live, peak, created and pending counts per action name")
+{
+    g_pActionsManager->ReportCensus();
+}
+
+CON_COMMAND(ext_actions_log, "Prints state of asynchronous log writer (ext_actions_log_async)")
+{
+    g_pActionsLog->Status();
+}
+
+CON_COMMAND(ext_actions_rules, "Lists action rules with their hit counts. Usage: ext_actions_rules [reload]")
+{
+    if (args.ArgC() > 1 && strcmp(args[1], "reload") == 0)
+    {
+        if (!g_pActionsRules->Load())
+            LOG("Failed to load configs/actions_rules.cfg, keeping current rules");
+
+        return;
+    }
+
+    g_pActionsRules->Dump();
+}
+
+CON_COMMAND(ext_actions_profile, "Handlers profiler. Usage: ext_actions_profile [start|stop|reset], prints report without arguments")
+{
+#ifdef NO_PROFILER
+    LOG("Extension was compiled without profiler");
+#else
+    if (args.ArgC() < 2)
+    {
+        g_pActionsProfiler->Report();
+        return;
+    }
+
+    const char* cmd = args[1];
+
+    if (strcmp(cmd, "start") == 0)
+    {
+        g_pActionsProfiler->SetEnabled(true);
+        LOG("Profiler started");
+    }
+    else if (strcmp(cmd, "stop") == 0)
+    {
+        g_pActionsProfiler->SetEnabled(false);
+        LOG("Profiler stopped");
+    }
+    else if (strcmp(cmd, "reset") == 0)
+    {
+        g_pActionsProfiler->Reset();
+        LOG("Profiler counters reset");
+    }
+    else
+    {
+        LOG("Unknown argument \"%s\", expected start, stop or reset", cmd);
+    }
+#endif
+}
+
+CON_COMMAND(ext_actions_recorder_dump, "Dump recorded action transitions. Usage: ext_actions_recorder_dump [csv|bin|clear] [file]")
+{
+    const char* format = args.ArgC() > 1 ? args[1] : "csv";
+
+    if (strcmp(format, "clear") == 0)
+    {
+        g_pActionsRecorder->Clear();
+        LOG("Recorder cleared");
+        return;
+    }
+
+    bool binary = strcmp(format, "bin") == 0;
+
+    if (!binary && strcmp(format, "csv") != 0)
+    {
+        LOG("Unknown format \"%s\", expected csv, bin or clear", format);
+        return;
+    }
+
+    char path[PLATFORM_MAX_PATH];
+
+    if (args.ArgC() > 2)
+        smutils->BuildPath(Path_SM, path, sizeof(path), "logs/%s", args[2]);
+    else
+        smutils->BuildPath(Path_SM, path, sizeof(path), "logs/actions_recorder.%s", format);
+
+    bool success = binary ? g_pActionsRecorder->DumpBinary(path) : g_pActionsRecorder->DumpCSV(path);
+
+    if (!success)
+    {
+        LOG("Failed to open \"%s\" for writing", path);
+        return;
+    }
+
+    LOG("Dumped %i records to \"%s\"", g_pActionsRecorder->GetCount(), path);
+}
+
 inline bool ClassMatchesComplex(cell_t entity, const char* match)
 {
     CBaseEntity* pEntity = gamehelpers->ReferenceToEntity(entity);
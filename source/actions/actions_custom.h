@@ -1,5 +1,13 @@
 #pragma once
 
+#include <string>
+#include <vector>
+
+#include <am-string.h>
+
+#include "actions_pool.h"
+#include "actions_manager.h"
+
 class PluginAction : public Action<void>
 {
 public:
@@ -8,9 +16,72 @@ public:
 		ke::SafeStrcpy(m_szName, sizeof(m_szName), name);
 	}
 
+	/* Pool hands freed block out again right away, manager must forget this address first */
+	~PluginAction()
+	{
+		g_pActionsManager->OnActionFreed(this);
+	}
+
+	/* Deleting destructor lives in our vtable, so engine deletes come back to the pool too */
+	static void* operator new(size_t size) { return g_pActionsPool->Alloc(size); }
+	static void operator delete(void* block, size_t size) { g_pActionsPool->Free(block, size); }
+
 	virtual const char* GetName(void) const override { return m_szName; }
 private:
 #define MAX_NAME_LENGTH 32
 	char m_szName[MAX_NAME_LENGTH * 2];
 };
 
+/*
+ * Plugin action type registered once. Handlers set on class are named listeners of its name,
+ * so instances share one handler table and nothing is registered per action.
+ */
+struct ActionClass
+{
+	std::string name;
+	uint32_t nameId;
+};
+
+class ClassAction : public Action<void>
+{
+public:
+	ClassAction(const ActionClass* actionClass) : m_class(actionClass)
+	{
+	}
+
+	~ClassAction()
+	{
+		g_pActionsManager->OnActionFreed(this);
+	}
+
+	static void* operator new(size_t size) { return g_pActionsPool->Alloc(size); }
+	static void operator delete(void* block, size_t size) { g_pActionsPool->Free(block, size); }
+
+	virtual const char* GetName(void) const override { return m_class->name.c_str(); }
+
+	const ActionClass* GetClass() const noexcept
+	{
+		return m_class;
+	}
+
+private:
+	const ActionClass* m_class;
+};
+
+/* Classes live for whole extension lifetime, plugins refer to them by 1 based index */
+class ActionClasses
+{
+public:
+	~ActionClasses();
+
+	/* Same class is returned when name is registered again */
+	cell_t Register(const char* name);
+	const ActionClass* Get(cell_t id) const;
+
+	ClassAction* Create(const ActionClass* actionClass);
+
+private:
+	std::vector<ActionClass*> m_classes;
+};
+
+extern ActionClasses* g_pActionClasses;
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "utils.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <am-hashmap.h>
+
+#include "NextBotBehavior.h"
+
+/*
+ * Generation tagged handles given to plugins instead of raw action addresses.
+ * Layout: bit 0 is always set (actions are at least 4 bytes aligned so raw addresses never have it),
+ * bits 1-15 are slot generation, bits 16-31 are slot index.
+ */
+class ActionHandles
+{
+	using Action = ::Action<void>;
+
+	struct Slot
+	{
+		Action* action;
+		uint16_t generation;
+	};
+
+	using HandlesIndex = ke::HashMap<Action*, uint32_t, ke::PointerPolicy<Action>>;
+
+public:
+	static constexpr uint32_t MAX_HANDLES = 1 << 16;
+	static constexpr uint32_t GENERATION_MASK = 0x7FFF;
+
+	ActionHandles();
+
+	NODISCARD static inline bool IsHandle(cell_t cell) noexcept
+	{
+		return (cell & 1) != 0;
+	}
+
+	/* Returns 0 if there are no free slots */
+	cell_t Acquire(Action* action);
+	cell_t Find(Action* action) const;
+	void Release(Action* action);
+
+	/* NULL for stale handles */
+	inline Action* Resolve(cell_t cell) const noexcept
+	{
+		const uint32_t bits = static_cast<uint32_t>(cell);
+		const uint32_t index = bits >> 16;
+		const uint32_t generation = (bits >> 1) & GENERATION_MASK;
+
+		if (index >= m_slots.size())
+			return NULL;
+
+		const Slot& slot = m_slots[index];
+
+		if (slot.generation != generation)
+			return NULL;
+
+		return slot.action;
+	}
+
+	size_t GetActiveCount() const noexcept
+	{
+		return m_slots.size() - m_free.size();
+	}
+
+	size_t GetMemoryUsage() const noexcept
+	{
+		return m_slots.capacity() * sizeof(Slot) + m_free.capacity() * sizeof(uint32_t) + m_index.estimateMemoryUse();
+	}
+
+private:
+	static inline cell_t MakeHandle(uint32_t index, uint32_t generation) noexcept
+	{
+		return static_cast<cell_t>((index << 16) | (generation << 1) | 1);
+	}
+
+private:
+	std::vector<Slot> m_slots;
+	std::vector<uint32_t> m_free;
+	mutable HandlesIndex m_index;
+};
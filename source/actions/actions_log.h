@@ -0,0 +1,83 @@
+#pragma once
+
+#include "utils.h"
+
+#include "extension.h"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <thread>
+
+/*
+ * Optional background sink for LOG and LOGDEBUG, enabled with ext_actions_log_async.
+ * Game thread formats message into a fixed record of lock-free single producer queue, writer thread appends records to rotating logs/actions.log.
+ * Queue never blocks, messages are dropped and counted once it's full. LOGERROR always stays synchronous.
+ */
+class ActionsLog
+{
+public:
+	static constexpr size_t RECORD_SIZE = 512;
+	static constexpr size_t CAPACITY = 4096;	// power of two
+	static constexpr long MAX_FILE_SIZE = 8 * 1024 * 1024;
+	static constexpr int MAX_FILES = 4;			// actions.log plus actions.log.1 .. actions.log.3
+	/* Room for ".N" suffix of rotated files */
+	static constexpr size_t MAX_PATH_LENGTH = PLATFORM_MAX_PATH + 16;
+
+	struct Record
+	{
+		time_t time;
+		uint32_t length;
+		char text[RECORD_SIZE - sizeof(time_t) - sizeof(uint32_t)];
+	};
+
+public:
+	ActionsLog();
+	~ActionsLog();
+
+	/* Game thread only, it's the single producer */
+	void Message(const char* fmt, va_list ap);
+
+	bool Start();
+	/* Waits for writer to drain the queue */
+	void Stop();
+
+	inline bool IsRunning() const noexcept
+	{
+		return m_thread.joinable();
+	}
+
+	void Status() const;
+
+private:
+	void Push(const char* fmt, va_list ap);
+
+	void Run();
+	size_t Drain();
+	void Write(const Record& record);
+	void Rotate();
+	bool FormatPath(char* buffer, size_t maxlength, int index) const;
+
+private:
+	std::unique_ptr<Record[]> m_records;
+	/* Producer owns head, writer owns tail */
+	std::atomic<size_t> m_head;
+	std::atomic<size_t> m_tail;
+	std::atomic<uint32_t> m_dropped;
+	std::atomic<bool> m_running;
+	std::thread m_thread;
+
+	/* Writer thread state */
+	FILE* m_file;
+	long m_fileSize;
+
+	char m_path[PLATFORM_MAX_PATH];
+	std::atomic<uint64_t> m_written;
+	uint32_t m_truncated;
+};
+
+extern ActionsLog* g_pActionsLog;
+extern ConVar ext_actions_log_async;
@@ -3,24 +3,17 @@
 #include "utils.h"
 
 #include <am-hashmap.h>
-#include <am-deque.h>
+#include <sm_stringhashmap.h>
 
-#include "NextBotBehavior.h"
+#include <vector>
+#include <string>
 
-class ActionsManager;
+#include "small_vector.h"
+#include "actions_handles.h"
 
-struct IntegerPolicy
-{
-	static inline uint32_t hash(cell_t i)
-	{
-		return ke::HashInteger<sizeof(cell_t)>(i);
-	}
+#include "NextBotBehavior.h"
 
-	static inline bool matches(cell_t i1, cell_t i2) noexcept
-	{
-		return i1 == i2;
-	}
-};
+class ActionsManager;
 
 class ActionsManager
 {
@@ -28,13 +21,60 @@ public:
 	ActionsManager();
 	~ActionsManager();
 
-	using Action = Action<void>;
-	using ActionsQueque = std::deque<ActionsManager::Action*>; 
-	//using ActionsQueque = std::vector<ActionsManager::Action*>;
-	using Actions = ke::HashMap<cell_t, ActionsQueque, IntegerPolicy>;
+	static constexpr cell_t MAX_ENTITIES = 2048;
+	static constexpr size_t INLINE_ACTIONS = 6;
 
-	using iterator = ActionsQueque::iterator;
-	using citerator = ActionsQueque::const_iterator;
+	using Action = ::Action<void>;
+	using ActionsQueque = SmallVector<ActionsManager::Action*, INLINE_ACTIONS>;
+	using Actions = ActionsQueque[MAX_ENTITIES];
+	using ActionsOwners = ke::HashMap<Action*, cell_t, ke::PointerPolicy<Action>>;
+	/* Created but not yet started actions, reports read entries only and never touch the action itself */
+	struct PendingAction
+	{
+		float created;		// gpGlobals->realtime
+		uint32_t nameId;
+	};
+	using PendingActions = ke::HashMap<ActionsManager::Action*, PendingAction, ke::PointerPolicy<ActionsManager::Action>>;
+
+	/* Plugins interested only in created/destroyed actions with given name */
+	struct NameWatchers
+	{
+		std::string name;
+		uint32_t nameId;
+		std::vector<IPluginFunction*> created;
+		std::vector<IPluginFunction*> destroyed;
+	};
+
+	using Watchers = ke::HashMap<uint32_t, NameWatchers*, ke::IntegerPolicy<uint32_t>>;
+
+	/* Plugins interested in behavior transitions, optionally of one entity or action name only */
+	struct ChangeWatcher
+	{
+		IPluginFunction* callback;
+		cell_t entity;		// entity index, -1 - any
+		uint32_t nameId;	// matches either side of transition, INVALID_NAME_ID - any
+	};
+
+	/* Maintained on add/remove, so reading them doesn't walk entities */
+	struct CensusCounters
+	{
+		uint32_t live;
+		uint32_t peak;
+		uint64_t created;
+		uint32_t pending;	// created by plugins and never started, counted on request
+	};
+
+	struct MemoryUsage
+	{
+		size_t table;		// entity slot table, allocated once
+		size_t spilled;		// heap storage of slots that outgrew inline buffer
+		size_t owners;		// Action* -> entity index
+		size_t pending;
+		size_t handles;
+		size_t userdata;
+		size_t entities;
+		size_t actions;
+	};
 
 	bool Add(cell_t entity, Action* action);
 	bool Add(CBaseEntity* entity, Action* action);
@@ -45,15 +85,59 @@ public:
 	bool Remove(Action* action);
 
 	size_t GetEntityActions(cell_t entity, std::vector<Action*>* actions = NULL);
+	cell_t GetActionOwner(Action* action) const;
+
+	template<typename F>
+	void ForEachAction(F&& callback) const
+	{
+		for (auto iter = m_owners.iter(); !iter.empty(); iter.next())
+			callback(iter->key);
+	}
+
+	void GetMemoryUsage(MemoryUsage& usage) const;
+
+	/* Counters of one action name, INVALID_NAME_ID sums every name. False if name was never captured nor pending */
+	bool GetCensus(uint32_t nameId, CensusCounters& counters) const;
+	void ReportCensus() const;
+
+	bool AddWatcher(const char* name, IPluginFunction* callback, bool destroyed);
+	bool RemoveWatcher(const char* name, IPluginFunction* callback, bool destroyed);
+	void RemoveWatchers(IPluginContext* context);
+
+	bool AddChangeWatcher(IPluginFunction* callback, cell_t entity, uint32_t nameId);
+	bool RemoveChangeWatcher(IPluginFunction* callback);
+	/* Keeps event handlers hooked while OnActionChanged forward or change watchers are used, called when either changes */
+	void UpdateChangeHooks();
+
+	/* Action requested CHANGE_TO, SUSPEND_FOR or DONE, called from CheckActionResult of pre and post processors */
+	void OnActionChanged(Action* action, ActionResultType type, Action* target, const char* reason, size_t vtableidx, bool post);
 	
 	bool AddPending(Action* action);
 	bool RemovePending(Action* action);
 
-	bool IsPending(Action* action, bool erase = false) const;
+	/* Action memory is about to be released, drops everything keyed by its address whether it was captured or pending */
+	void OnActionFreed(Action* action);
+
+	bool IsPending(Action* action) const;
+	void ReportPending() const;
 
 	bool IsValidAction(Action* action) const;
+
+	/* Bots of intention types set to "ignore" in gamedata, their actions never reach manager or hooks */
+	void SetEntityIgnored(CBaseEntity* entity, bool ignored);
+	bool IsEntityIgnored(CBaseEntity* entity) const;
+
+	/* Name id of intention type that reset bot last, INVALID_NAME_ID for unknown */
+	void SetEntityIntention(CBaseEntity* entity, uint32_t nameId);
+	uint32_t GetEntityIntention(CBaseEntity* entity) const;
 	bool IsValidResult(const void* const result) const;
 
+	/* Plugins see actions as raw addresses or as handles when ext_actions_handles is enabled, both forms are accepted */
+	cell_t ToCell(Action* action);
+	Action* FromCell(cell_t cell) const noexcept;
+	/* Same as FromCell but validated, NULL if action is not valid anymore */
+	Action* ResolveAction(cell_t cell) const;
+
 	void SetRuntimeAction(Action* action) noexcept;
 	Action* GetRuntimeAction() const noexcept;
 
@@ -63,23 +147,64 @@ public:
 	void SetRuntimeActor(CBaseEntity* actor) noexcept;
 	CBaseEntity* GetRuntimeActor() const noexcept;
 
+	/* CTakeDamageInfo or KeyValues of handler being dispatched, argument natives accept only it */
+	void SetRuntimeArg(const void* arg) noexcept;
+	const void* GetRuntimeArg() const noexcept;
+
 private:
 	static void OnActionAdded(Action* action);
 	static void OnActionDestroyed(Action* action);
 
+	void EnforcePendingLimits(Action* added);
+	void CountCensus(Action* action, bool added);
+	void UntrackPending(Action* action);
+	const char* PendingName(Action* action) const;
+
+	void NotifyWatchers(Action* action, cell_t actor, bool destroyed);
+	void DestroyWatchers(NameWatchers* watchers);
+
 	NODISCARD bool IsCaptured(cell_t entity, Action* action) const;
 	NODISCARD bool IsCaptured(Action* action) const;
 	NODISCARD bool IsCaptured(cell_t entity) const;
 
+	NODISCARD static bool IsValidEntity(cell_t entity) noexcept
+	{
+		return entity >= 0 && entity < MAX_ENTITIES;
+	}
+
 private:
 	bool m_init;
 
 	mutable Actions m_actions;
-	mutable ActionsQueque m_pendingActions;
+	mutable ActionsOwners m_owners;
+	mutable PendingActions m_pendingActions;
+	float m_lastPendingSweep;
+	ActionHandles m_handles;
+
+	Watchers m_watchers;
+	std::vector<NameWatchers*> m_watchersList;
+	std::vector<ChangeWatcher> m_changeWatchers;
+	bool m_changeHooks;
+	/* Indexed by name id */
+	std::vector<CensusCounters> m_census;
+	CensusCounters m_censusTotal;
+	/* Dispatches whose pre processor already reported transition, their post processor skips it */
+	struct ReportedChange
+	{
+		Action* action;
+		size_t vtableidx;
+	};
+	std::vector<ReportedChange> m_reportedChanges;
+
+	/* Entity reference per index so reused index is not ignored, 0 - tracked */
+	cell_t m_ignored[MAX_ENTITIES];
+	size_t m_ignoredCount;
+	uint32_t m_intentions[MAX_ENTITIES];
 
 	CBaseEntity* m_pRuntimeActor;
 	Action* m_pRuntimeAction;
 	void* m_pRuntimeResult;
+	const void* m_pRuntimeArg;
 };
 
 extern ActionsManager* g_pActionsManager;
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "utils.h"
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+#include <am-hashmap.h>
+#include <sm_stringhashmap.h>
+
+#include "NextBotBehavior.h"
+
+/*
+ * Interned action names. Ids are stable for whole extension lifetime and never reused,
+ * id 0 is reserved for "no name".
+ * Game actions return constant name per class, so name id is cached per vtable after first lookup.
+ */
+class ActionsNames
+{
+public:
+	static constexpr uint32_t INVALID_NAME_ID = 0;
+
+	ActionsNames();
+
+	uint32_t Intern(const char* name);
+
+	/* Cached per vtable, dynamic vtables (plugin actions) are looked up by name every time */
+	uint32_t GetNameId(Action<void>* action);
+	void AddDynamicVTable(void* vtable);
+
+	/* INVALID_NAME_ID if name was never interned */
+	uint32_t Lookup(const char* name) const;
+
+	/* NULL for unknown ids */
+	inline const char* GetName(uint32_t id) const noexcept
+	{
+		if (id == INVALID_NAME_ID || id >= m_names.size())
+			return NULL;
+
+		return m_names[id].c_str();
+	}
+
+	size_t GetCount() const noexcept
+	{
+		return m_names.size() - 1;
+	}
+
+private:
+	static constexpr uint32_t DYNAMIC_NAME_ID = UINT32_MAX;
+
+	using VTableNames = ke::HashMap<void*, uint32_t, ke::PointerPolicy<void>>;
+
+private:
+	mutable StringHashMap<uint32_t> m_ids;
+	VTableNames m_vtables;
+	std::vector<std::string> m_names;
+};
+
+extern ActionsNames* g_pActionsNames;
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "utils.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Size class free lists for action sized blocks.
+ * Every block is a separate ::operator new allocation, so engine is free to delete pooled actions
+ * it owns with normal delete, blocks simply come back to us only through paths we control.
+ */
+class ActionsPool
+{
+public:
+	static constexpr size_t GRANULARITY = 16;
+	static constexpr size_t MAX_BLOCK_SIZE = 1024;
+	static constexpr size_t CLASSES = MAX_BLOCK_SIZE / GRANULARITY;
+	static constexpr size_t MAX_CACHED = 64;
+
+	struct SizeClassStats
+	{
+		uint32_t live;		// allocated and not yet returned to pool
+		uint32_t peak;
+		uint32_t cached;	// free blocks waiting for reuse
+		uint64_t allocs;
+		uint64_t recycled;	// allocations served from free list
+		uint64_t detached;	// blocks handed to plugins/engine, never returned to pool
+	};
+
+public:
+	ActionsPool();
+	~ActionsPool();
+
+	/* Detached blocks are owned by whoever deletes them (ActionsManager.Allocate + game constructor) */
+	void* Alloc(size_t size, bool detached = false);
+	/* Block is reused LIFO, owner's destructor has to release everything keyed by its address before */
+	void Free(void* block, size_t size);
+
+	/* Releases cached blocks back to heap */
+	void Flush();
+	void Report() const;
+
+private:
+	static inline size_t GetSizeClass(size_t size) noexcept
+	{
+		return (size + GRANULARITY - 1) / GRANULARITY - 1;
+	}
+
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+private:
+	FreeBlock* m_free[CLASSES];
+	SizeClassStats m_stats[CLASSES];
+	uint64_t m_oversized;
+};
+
+extern ActionsPool* g_pActionsPool;
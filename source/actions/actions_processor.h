@@ -1,8 +1,11 @@
 #pragma once
 
 #include <utility>
+#include <tuple>
 #include <map>
 
+#include <am-hashmap.h>
+
 #include "utils.h"
 
 #include "extension.h"
@@ -10,11 +13,33 @@
 
 #include "actions_manager.h"
 #include "actions_propagate.h"
+#include "actions_profiler.h"
+#include "actions_batch.h"
+#include "actions_rules.h"
 
 #include "NextBotBehavior.h"
 #include "NextBotIntentionInterface.h"
 
 extern std::map<std::string, size_t>& GetOffsetsInfo();
+extern size_t GetHandlerOffset(const char* name);
+
+/* Offset of handler plugins may listen to, reports error to plugin and returns 0 otherwise */
+inline size_t GetListenableHandlerOffset(IPluginContext* pContext, const char* handler)
+{
+	/* Destructor is hooked for bookkeeping only, it never reaches listeners */
+	if (strcmp(handler, "OnDestroyed") == 0)
+	{
+		pContext->ReportError("OnDestroyed can't be hooked, use ActionsManager.WatchDestroyed instead");
+		return 0;
+	}
+
+	size_t vtableidx = GetHandlerOffset(handler);
+
+	if (vtableidx == 0)
+		pContext->ReportError("Unknown event handler \"%s\"", handler);
+
+	return vtableidx;
+}
 
 extern void HookIntentions(IGameConfig* config);
 extern void ReconfigureHooks();
@@ -22,24 +47,30 @@ extern void ReconfigureHooks();
 #define DEFINE_PROCESSOR(unique, name, ret, ...)	\
 	HandlerProcessor<unique, ret, ##__VA_ARGS__> name
 
-#define START_PROCESSOR(hookname, varname)	\
-	SH_ADD_MANUALVPHOOK(hookname, static_cast<void*>(action), SH_STATIC(decltype(varname)::Process), false); \
-	SH_ADD_MANUALVPHOOK(hookname, static_cast<void*>(action), SH_STATIC(decltype(varname)::ProcessPost), true); \
-	varname.vtableindex = offsets[#hookname]; \
-	varname.name = #hookname
+/* Processors that do extra bookkeeping besides propagating to listeners */
+enum : size_t
+{
+	PROCESSOR_END = 13,
+	PROCESSOR_SUSPEND = 14
+};
 
 class ActionProcessor;
 static void CreateActionProcessor(CBaseEntity* entity, Action<void>* action);
 
 template<typename T>
-static void CheckActionResult(Action<void>* action, T& result)
+static void CheckActionResult(Action<void>* action, T& result, size_t vtableidx, bool post)
 {
 	if (!result.IsRequestingChange())
 		return;
 
+	g_pActionsRecorder->OnActionResult(action, vtableidx, result.m_type, result.m_action);
+
+	/* Target is captured first, so observers get it in the same form natives return it later */
 	if (!result.IsDone())
 		CreateActionProcessor(static_cast<CBaseEntity*>(action->GetActor()), result.m_action);
 
+	g_pActionsManager->OnActionChanged(action, result.m_type, result.m_action, result.m_reason, vtableidx, post);
+
 	if (result.m_type != SUSPEND_FOR)
 		g_pActionsManager->Remove(action);
 }
@@ -47,6 +78,8 @@ static void CheckActionResult(Action<void>* action, T& result)
 template<size_t unique, typename retn, typename... Args>
 struct HandlerProcessor
 {
+	using result_type = retn;
+
 	inline static size_t vtableindex;
 	inline static const char* name;
 
@@ -55,6 +88,17 @@ struct HandlerProcessor
 		Action<void>* action = META_IFACEPTR(Action<void>);
 		CBaseEntity* actor = static_cast<CBaseEntity*>(action->GetActor());
 
+		PROFILE_HANDLER(vtableindex, false);
+
+		/* Event handlers may be left unhooked, so catch actions they requested when transition happens */
+		if constexpr (unique == PROCESSOR_END || unique == PROCESSOR_SUSPEND)
+		{
+			Action<void>* next = std::get<1>(std::forward_as_tuple(arg...));
+
+			if (next && g_pActionsManager->GetActionOwner(next) == -1)
+				CreateActionProcessor(actor, next);
+		}
+
 		if constexpr (std::is_void<retn>::value)
 		{
 		#ifndef __linux__
@@ -63,10 +107,15 @@ struct HandlerProcessor
 			if (vtableindex == 1)
 		#endif
 			{
-				g_pActionsManager->Remove(action);
+				g_pActionsManager->OnActionFreed(action);
 			}
 			else
 			{
+				if (!g_pActionsPropagatePre->HasListeners(vtableindex))
+				{
+					RETURN_META(MRES_IGNORED);
+				}
+
 				void* returnValue = NULL;
 				ResultType result = g_pActionsPropagatePre->ProcessHandler(vtableindex, action, &returnValue, std::forward<Args>(arg)...);
 
@@ -80,6 +129,21 @@ struct HandlerProcessor
 		}
 		else
 		{
+			/* Matched rule answers instead of game and listeners */
+			if constexpr (std::is_same<retn, ActionResult<void>>::value || std::is_same<retn, EventDesiredResult<void>>::value)
+			{
+				if (g_pActionsRules->HasRules(vtableindex))
+				{
+					retn ruleResult;
+
+					if (g_pActionsRules->Apply(vtableindex, action, ruleResult))
+					{
+						CheckActionResult(action, ruleResult, vtableindex, false);
+						RETURN_META_VALUE(MRES_SUPERCEDE, ruleResult);
+					}
+				}
+			}
+
 			retn returnValue = META_RESULT_ORIG_RET(retn), originalReturn;
 			originalReturn = returnValue;
 
@@ -104,7 +168,7 @@ struct HandlerProcessor
 			{
 				if constexpr (std::is_same<retn, ActionResult<void>>::value || std::is_same<retn, EventDesiredResult<void>>::value)
 				{
-					CheckActionResult(action, returnValue);
+					CheckActionResult(action, returnValue, vtableindex, false);
 				}
 
 				if (result == Pl_Handled)
@@ -126,6 +190,8 @@ struct HandlerProcessor
 		Action<void>* action = META_IFACEPTR(Action<void>);
 		CBaseEntity* actor = static_cast<CBaseEntity*>(action->GetActor());
 
+		PROFILE_HANDLER(vtableindex, true);
+
 		if constexpr (std::is_void<retn>::value)
 		{
 		#ifndef __linux__
@@ -134,6 +200,11 @@ struct HandlerProcessor
 			if (vtableindex != 1)
 		#endif
 			{
+				if (!g_pActionsPropagatePost->HasListeners(vtableindex))
+				{
+					RETURN_META(MRES_IGNORED);
+				}
+
 				void* returnValue = NULL;
 				ResultType result = g_pActionsPropagatePost->ProcessHandler(vtableindex, action, &returnValue, std::forward<Args>(arg)...);
 
@@ -147,6 +218,13 @@ struct HandlerProcessor
 		}
 		else
 		{
+			/* Batched observers see event as game dispatched it, before listeners below had a chance to change anything */
+			if constexpr (std::is_same<retn, EventDesiredResult<void>>::value)
+			{
+				if (g_pActionsBatch->IsBatched(vtableindex))
+					g_pActionsBatch->Append(vtableindex, action, arg...);
+			}
+
 			retn returnValue = META_RESULT_ORIG_RET(retn), originalReturn;
 			originalReturn = returnValue;
 
@@ -190,7 +268,7 @@ struct HandlerProcessor
 			{
 				if constexpr (std::is_same<retn, ActionResult<void>>::value || std::is_same<retn, EventDesiredResult<void>>::value)
 				{
-					CheckActionResult(action, returnValue);
+					CheckActionResult(action, returnValue, vtableindex, true);
 				}
 
 				if (result == Pl_Handled)
@@ -210,13 +288,38 @@ struct HandlerProcessor
 
 class ActionProcessor
 {
-	inline static std::vector<std::string> m_hookedNames;
+	struct VTableHooks;
+
+	/* SourceHook hooks per vtable so two classes with same name are still hooked separately */
+	using HookedVTables = ke::HashMap<void*, VTableHooks*, ke::PointerPolicy<void>>;
+
+	static HookedVTables& GetHookedVTables();
+	static VTableHooks* FindOrHookVTable(void* vtable);
+
+	static void HookHandler(VTableHooks* hooks, size_t slot, bool post);
+	static void UnhookHandler(VTableHooks* hooks, size_t slot, bool post);
 
 public:
 	ActionProcessor(CBaseEntity* entity, Action<void>* action);
 	ActionProcessor(Action<void>* action);
 
 	~ActionProcessor() = default;
+
+	/* Listeners bookkeeping, with lazy hooks handler is hooked only while someone listens to it */
+	static void RequestHook(Action<void>* action, size_t vtableidx, bool post, size_t count = 1);
+	static void ReleaseHook(Action<void>* action, size_t vtableidx, bool post, size_t count = 1);
+
+	/* Same for listeners of every action, handler stays hooked on all vtables while requested */
+	static void RequestHandler(size_t vtableidx, bool post);
+	static void ReleaseHandler(size_t vtableidx, bool post);
+
+	/* Every event handler, transitions they request are seen only while they are hooked */
+	static void RequestEventHandlers(bool post);
+	static void ReleaseEventHandlers(bool post);
+
+	static bool IsHandlerHooked(Action<void>* action, size_t vtableidx, bool post);
+
+	static void ConfigureHandlers();
 public:
 	Action<void>* m_action;
 
@@ -229,8 +332,8 @@ public:
 
 	DEFINE_PROCESSOR(1, start, ActionResult<void>, CBaseEntity*, Action<void>*);
 	DEFINE_PROCESSOR(12, update, ActionResult<void>, CBaseEntity*, float);
-	DEFINE_PROCESSOR(13, end, void, CBaseEntity*, Action<void>*);
-	DEFINE_PROCESSOR(14, suspend, ActionResult<void>, CBaseEntity*, Action<void>*);
+	DEFINE_PROCESSOR(PROCESSOR_END, end, void, CBaseEntity*, Action<void>*);
+	DEFINE_PROCESSOR(PROCESSOR_SUSPEND, suspend, ActionResult<void>, CBaseEntity*, Action<void>*);
 	DEFINE_PROCESSOR(15, resume, ActionResult<void>, CBaseEntity*, Action<void>*);
 	DEFINE_PROCESSOR(16, initialAction, Action<void>*, CBaseEntity*);
 	DEFINE_PROCESSOR(17, leaveGround, EventDesiredResult<void>, CBaseEntity*, CBaseEntity*);
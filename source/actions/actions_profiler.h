@@ -0,0 +1,130 @@
+#pragma once
+
+#include "utils.h"
+
+#include "extension.h"
+
+#include <chrono>
+#include <cstdint>
+
+#include <am-hashmap.h>
+#include <sm_stringhashmap.h>
+
+#include "NextBotBehavior.h"
+
+/*
+ * Counters for event handlers, action names and plugins.
+ * Disabled by default, when disabled every probe costs one branch. Define NO_PROFILER in utils.h to compile it out.
+ */
+class ActionsProfiler
+{
+public:
+	static constexpr size_t SIZE = 100;
+
+	using Clock = std::chrono::steady_clock;
+
+	struct Stats
+	{
+		uint64_t calls;		// handler invocations, including ones without listeners (for actions only ones with listeners)
+		uint64_t listeners;	// listeners found per invocation, summed
+		uint64_t callbacks;	// plugin callbacks executed
+		double total;		// seconds spent in plugin callbacks
+		double max;			// longest single callback
+
+		void AddCallback(double seconds) noexcept
+		{
+			callbacks++;
+			total += seconds;
+
+			if (seconds > max)
+				max = seconds;
+		}
+	};
+
+	/* Measures single plugin callback */
+	class Scope
+	{
+	public:
+		inline Scope(size_t vtableidx, bool post, Action<void>* action, IPluginFunction* listener) noexcept;
+		inline ~Scope();
+
+	private:
+		bool m_active;
+		bool m_post;
+		size_t m_vtableidx;
+		Action<void>* m_action;
+		IPluginFunction* m_listener;
+		Clock::time_point m_start;
+	};
+
+	using PluginsStats = ke::HashMap<IPluginRuntime*, Stats, ke::PointerPolicy<IPluginRuntime>>;
+	using ActionsStats = StringHashMap<Stats>;
+
+public:
+	ActionsProfiler();
+
+	inline bool IsEnabled() const noexcept
+	{
+		return m_enabled;
+	}
+
+	void SetEnabled(bool enabled) noexcept;
+	void Reset();
+	void Report();
+
+	inline void OnHandler(size_t vtableidx, bool post) noexcept
+	{
+		if (vtableidx < SIZE)
+			m_handlers[vtableidx][post].calls++;
+	}
+
+	void OnDispatch(size_t vtableidx, bool post, Action<void>* action, size_t listeners);
+	void OnCallback(size_t vtableidx, bool post, Action<void>* action, IPluginFunction* listener, double seconds);
+	void OnPluginUnloaded(IPluginRuntime* runtime);
+
+private:
+	bool m_enabled;
+	Clock::time_point m_since;
+
+	Stats m_handlers[SIZE][2];
+	ActionsStats m_actions;
+	PluginsStats m_plugins;
+};
+
+extern ActionsProfiler* g_pActionsProfiler;
+
+inline ActionsProfiler::Scope::Scope(size_t vtableidx, bool post, Action<void>* action, IPluginFunction* listener) noexcept : m_active(g_pActionsProfiler->IsEnabled())
+{
+	if (!m_active)
+		return;
+
+	m_post = post;
+	m_vtableidx = vtableidx;
+	m_action = action;
+	m_listener = listener;
+	m_start = Clock::now();
+}
+
+inline ActionsProfiler::Scope::~Scope()
+{
+	if (!m_active)
+		return;
+
+	std::chrono::duration<double> elapsed = Clock::now() - m_start;
+	g_pActionsProfiler->OnCallback(m_vtableidx, m_post, m_action, m_listener, elapsed.count());
+}
+
+#ifndef NO_PROFILER
+	#define PROFILE_HANDLER(vtableidx, post) \
+		if (g_pActionsProfiler->IsEnabled()) g_pActionsProfiler->OnHandler(vtableidx, post)
+
+	#define PROFILE_DISPATCH(vtableidx, post, action, listeners) \
+		if (g_pActionsProfiler->IsEnabled()) g_pActionsProfiler->OnDispatch(vtableidx, post, action, listeners)
+
+	#define PROFILE_CALLBACK(vtableidx, post, action, listener) \
+		ActionsProfiler::Scope profileScope(vtableidx, post, action, listener)
+#else
+	#define PROFILE_HANDLER(vtableidx, post) ((void)0)
+	#define PROFILE_DISPATCH(vtableidx, post, action, listeners) ((void)0)
+	#define PROFILE_CALLBACK(vtableidx, post, action, listener) ((void)0)
+#endif
@@ -6,10 +6,17 @@
 #include "actions_manager.h"
 
 #include <vector>
+#include <string>
+#include <bitset>
+#include <cstring>
 
 #include <am-hashset.h>
 #include <am-hashmap.h>
-#include <am-fixedarray.h>
+#include <sm_stringhashmap.h>
+
+#include "small_vector.h"
+#include "actions_profiler.h"
+#include "actions_recorder.h"
 
 #include "NextBotBehavior.h"
 
@@ -17,22 +24,114 @@ class ActionsPropagate
 {
 	friend class ActionsManager;
 
+public:
 	static const cell_t SIZE = 100;
+	static_assert(SIZE <= ActionsProfiler::SIZE, "Profiler must cover every handler");
 
+private:
 	using Action = ActionsManager::Action;
 
-	using PluginCallbacks = std::vector<IPluginFunction*>;
-	using HandlersArray = ke::FixedArray<PluginCallbacks>;
-	using ActionsHandler = ke::HashMap<Action*, HandlersArray, ke::PointerPolicy<Action>>;
+	/* Higher priority listeners are called first, equal priorities keep registration order */
+	struct PluginCallback
+	{
+		IPluginFunction* function;
+		int priority;
+		float interval;		// min seconds between calls for same action, 0 - every call
+		bool stop;			// Plugin_Stop returned from it skips lower priority listeners
+
+		inline operator IPluginFunction*() const noexcept { return function; }
+		inline IPluginFunction* operator->() const noexcept { return function; }
+	};
+
+	using PluginCallbacks = std::vector<PluginCallback>;
+	using CallbacksSnapshot = SmallVector<PluginCallback, 8>;
+
+	struct HandlerCallbacks
+	{
+		size_t vtableidx;
+		PluginCallbacks callbacks;
+	};
+
+	/* Only handlers that were ever listened are stored, mask tells which vtable indexes are present */
+	struct ActionHandlers
+	{
+		ActionHandlers() : listeners(0)
+		{
+		}
+
+		PluginCallbacks* Find(size_t vtableidx)
+		{
+			if (!mask.test(vtableidx))
+				return NULL;
+
+			for (auto& handler : handlers)
+			{
+				if (handler.vtableidx == vtableidx)
+					return &handler.callbacks;
+			}
+
+			return NULL;
+		}
+
+		PluginCallbacks& FindOrAdd(size_t vtableidx)
+		{
+			PluginCallbacks* callbacks = Find(vtableidx);
+
+			if (callbacks)
+				return *callbacks;
+
+			mask.set(vtableidx);
+			handlers.push_back({ vtableidx, PluginCallbacks() });
+			return handlers.back().callbacks;
+		}
+
+		std::bitset<SIZE> mask;
+		std::vector<HandlerCallbacks> handlers;
+		size_t listeners;
+	};
+
+	/* Listeners shared by every action with given name */
+	struct NamedHandlers
+	{
+		std::string name;
+		uint32_t nameId;
+		ActionHandlers handlers;
+	};
+
+	/* Back reference from plugin to actions it listens, so unload doesn't walk every action */
+	struct ContextListeners
+	{
+		std::bitset<SIZE> mask;
+		size_t count;
+	};
+
+	/* When throttled listener may be called again for this action */
+	struct ThrottleState
+	{
+		IPluginFunction* listener;
+		uint32_t vtableidx;
+		float next;
+	};
+
+	using ThrottleStates = std::vector<ThrottleState>;
+	using Throttles = ke::HashMap<Action*, ThrottleStates, ke::PointerPolicy<Action>>;
+
+	using ContextActions = ke::HashMap<Action*, ContextListeners, ke::PointerPolicy<Action>>;
+	using ContextsIndex = ke::HashMap<IPluginContext*, ContextActions*, ke::PointerPolicy<IPluginContext>>;
+
+	using ActionsHandler = ke::HashMap<Action*, ActionHandlers, ke::PointerPolicy<Action>>;
+	using NamedHandlersMap = ke::HashMap<uint32_t, NamedHandlers*, ke::IntegerPolicy<uint32_t>>;
+	using NamedActions = ke::HashMap<Action*, NamedHandlers*, ke::PointerPolicy<Action>>;
 
 	static void OnActionAdded(Action* action);
 	static void OnActionDestroyed(Action* action);
 
 public:
-	ActionsPropagate();
+	ActionsPropagate(bool post);
 	~ActionsPropagate() = delete;
 
-	bool AddListener(size_t vtableidx, Action* action, IPluginFunction* listener);
+	/* Listener with interval is skipped until that many seconds (gpGlobals->curtime) passed since its last call for the action */
+	bool AddListener(size_t vtableidx, Action* action, IPluginFunction* listener, int priority = 0, float interval = 0.0f, bool stop = false);
 	
 	bool RemoveListener(size_t vtableidx, Action* action, IPluginFunction* listener);
 	bool RemoveListener(size_t vtableidx, Action* action, IPluginContext* context);
@@ -44,46 +143,106 @@ public:
 	bool FindListener(size_t vtableidx, Action* action, IPluginFunction* listener, PluginCallbacks::iterator* iter = NULL);
 	bool FindListener(size_t vtableidx, IPluginFunction* listener, PluginCallbacks::iterator* iter = NULL);
 
+	/* Listeners for every action with given name, instance listeners are still called after them */
+	bool AddNamedListener(size_t vtableidx, const char* name, IPluginFunction* listener, int priority = 0, float interval = 0.0f, bool stop = false);
+	bool RemoveNamedListener(size_t vtableidx, const char* name, IPluginFunction* listener);
+
+	/* Cheap check that doesn't touch actions table, used to skip dispatch when nobody listens */
+	inline bool HasListeners(size_t vtableidx) const noexcept
+	{
+		return m_listeners[vtableidx] != 0;
+	}
+
+	/* Handler argument converted once per dispatch and pushed to every listener from here */
+	struct HandlerArg
+	{
+		enum class Type : uint8_t
+		{
+			Cell,
+			Float,
+			String,
+			Vector
+		};
+
+		Type type;
+
+		union
+		{
+			cell_t cell;
+			float value;
+			const char* string;
+			cell_t vector[3];
+		};
+	};
+
 	template<typename T>
-	void ProcessHandleArg(PluginCallbacks& callbacks, T&& arg)
+	static void MarshalArg(HandlerArg& out, T&& arg)
 	{
 		using type = std::remove_const_t<std::remove_reference_t<T>>;
 
-		for (auto listener : callbacks)
+		if constexpr (std::is_same<type, float>::value)
 		{
-			if constexpr (std::is_same<type, float>::value)
-			{
-				listener->PushFloat((float)arg);
-			}
-			else if constexpr (std::is_same<type, char*>::value)
-			{
-				listener->PushString((char*)arg);
-			}
-			else if constexpr (std::is_same<type, Vector>::value)
-			{
-				listener->PushArray((cell_t*)&arg, sizeof(Vector));
-			}
-			else if constexpr (std::is_same<type, CBaseEntity*>::value)
-			{
-				cell_t entity = -1;
+			out.type = HandlerArg::Type::Float;
+			out.value = (float)arg;
+		}
+		else if constexpr (std::is_same<type, char*>::value || std::is_same<type, const char*>::value)
+		{
+			out.type = HandlerArg::Type::String;
+			out.string = arg != NULL ? arg : "";
+		}
+		else if constexpr (std::is_same<type, Vector>::value)
+		{
+			out.type = HandlerArg::Type::Vector;
+			memcpy(out.vector, &arg, sizeof(out.vector));
+		}
+		else if constexpr (std::is_same<type, CBaseEntity*>::value)
+		{
+			out.type = HandlerArg::Type::Cell;
+			out.cell = arg != NULL ? gamehelpers->EntityToBCompatRef(arg) : -1;
+		}
+		else if constexpr (std::is_same<type, Action*>::value)
+		{
+			out.type = HandlerArg::Type::Cell;
+			out.cell = g_pActionsManager->ToCell(arg);
+		}
+		else if constexpr (std::is_same<type, const CTakeDamageInfo*>::value || std::is_same<type, KeyValues*>::value)
+		{
+			/* Plugins read it with ActionDamageInfo/ActionKeyValues natives, valid only while handler runs */
+			g_pActionsManager->SetRuntimeArg(arg);
 
-				if (arg != NULL)
-					entity = gamehelpers->EntityToBCompatRef(arg);
+			out.type = HandlerArg::Type::Cell;
+			out.cell = (cell_t)(intptr_t)arg;
+		}
+		else if constexpr (std::is_same<type, int>::value || std::is_pointer<type>::value || std::is_enum<type>::value)
+		{
+			out.type = HandlerArg::Type::Cell;
+			out.cell = (cell_t)(intptr_t)arg;
+		}
+		else
+		{
+			static_assert(sizeof(type) <= sizeof(cell_t), "Handler argument can't be passed as cell");
 
-				listener->PushCell(entity);
-			}
-			else if constexpr (std::is_same<type, int>::value || std::is_pointer<T>::value || std::is_enum<T>::value)
-			{
-				listener->PushCell((cell_t)arg);
-			}
-			else
-			{
-				/* TO DO: */
-				listener->PushCell((cell_t)arg);
-				//typedef typename T::something_made_up X;
-				//bool x = decltype(arg)::nothing; 
-				//static_assert(false);
-			}
+			out.type = HandlerArg::Type::Cell;
+			out.cell = (cell_t)arg;
+		}
+	}
+
+	static inline void PushArg(IPluginFunction* listener, HandlerArg& arg)
+	{
+		switch (arg.type)
+		{
+			case HandlerArg::Type::Float:
+				listener->PushFloat(arg.value);
+				break;
+			case HandlerArg::Type::String:
+				listener->PushString(arg.string);
+				break;
+			case HandlerArg::Type::Vector:
+				listener->PushArray(arg.vector, 3);
+				break;
+			default:
+				listener->PushCell(arg.cell);
+				break;
 		}
 	}
 
@@ -92,35 +251,88 @@ public:
 	{
 		constexpr size_t num = sizeof...(Args);
 
+		if (!HasListeners(vtableidx))
+			return Pl_Continue;
+
+		/* Listeners are free to add or remove handlers while we are executing them */
+		CallbacksSnapshot listeners;
+
+		if (m_namedActions.elements() != 0)
+		{
+			auto n = m_namedActions.find(action);
+
+			if (n.found())
+				AppendCallbacks(listeners, n->value->handlers, vtableidx);
+		}
+
+		const size_t named = listeners.size();
 		auto r = m_handlers.find(action);
 
-		if (!r.found())
-			return Pl_Continue;
-		
-		auto& listeners = r->value[vtableidx];
+		if (r.found())
+			AppendCallbacks(listeners, r->value, vtableidx);
 
-		if (listeners.size() == 0)
+		if (listeners.empty())
 			return Pl_Continue;
 
+		PROFILE_DISPATCH(vtableidx, m_post, action, listeners.size());
+
+		/* Both lists are sorted already, merge them keeping named listeners first on same priority */
+		if (named != 0 && named != listeners.size())
+			SortCallbacks(listeners);
+
 		ResultType returnResult, executeResult = Pl_Continue;
 		returnResult = executeResult;
+		IPluginFunction* changer = NULL;
 
+		const float now = gpGlobals->curtime;
+		const void* runtimeArg = g_pActionsManager->GetRuntimeArg();
 		g_pActionsManager->SetRuntimeResult((void*)result);
-		ProcessHandleArg<Action*>(listeners, std::forward<Action*>(action));
-		(ProcessHandleArg<Args>(listeners, std::forward<Args>(args)), ...);
 
-		for (IPluginFunction* listener : listeners)
+		/* Entity refs, handles and vectors are converted once and not per listener */
+		HandlerArg marshalled[num + 1];
+		size_t arg = 0;
+
+		MarshalArg(marshalled[arg++], action);
+		(MarshalArg(marshalled[arg++], args), ...);
+
+		for (const PluginCallback& callback : listeners)
 		{
+			IPluginFunction* listener = callback.function;
+
+			/* Throttled before anything is pushed, skipped listener costs no VM call */
+			if (callback.interval > 0.0f && !PassThrottle(action, vtableidx, callback, now))
+				continue;
+
+			/* Arguments are pushed right before execute so skipped listeners have nothing pending */
+			for (HandlerArg& marshal : marshalled)
+				PushArg(listener, marshal);
+
+			/* Returned action may come back as handle */
+			cell_t actionCell = 0;
+
 			if constexpr (std::is_same<returnType, ActionResult<void>>::value || std::is_same<returnType, EventDesiredResult<void>>::value)
 			{
-				listener->PushCell((cell_t)result);
+				listener->PushCell((cell_t)(intptr_t)result);
+			}
+			else if constexpr (std::is_same<returnType, Action*>::value)
+			{
+				actionCell = g_pActionsManager->ToCell(*result);
+				listener->PushCellByRef(&actionCell);
 			}
 			else
 			{
 				listener->PushCellByRef((cell_t*)result);
 			}
 
-			listener->Execute((cell_t*)&executeResult);
+			{
+				PROFILE_CALLBACK(vtableidx, m_post, action, listener);
+				listener->Execute((cell_t*)&executeResult);
+			}
+
+			if constexpr (std::is_same<returnType, Action*>::value)
+			{
+				*result = g_pActionsManager->FromCell(actionCell);
+			}
 
 			if constexpr (std::is_same<returnType, ActionResult<void>>::value || std::is_same<returnType, EventDesiredResult<void>>::value)
 			{
@@ -137,20 +349,100 @@ public:
 					if (runtimeAction && result->m_action != runtimeAction)
 					{
 						g_pActionsManager->SetRuntimeAction(result->m_action);
+						g_pActionsManager->OnActionFreed(runtimeAction);
 						delete runtimeAction;
 					}
 				}
 			}
 
 			if (executeResult > returnResult)
+			{
 				returnResult = executeResult;
+				changer = listener;
+			}
+
+			if (callback.stop && executeResult == Pl_Stop)
+				break;
 		}
 
+		/* Nested dispatch from a callback must not leave outer argument invalid */
+		g_pActionsManager->SetRuntimeArg(runtimeArg);
+
+		if (returnResult >= Pl_Changed)
+			g_pActionsRecorder->OnHandlerChanged(action, vtableidx, m_post, returnResult, changer);
+
 		return returnResult;
 	}
 
+private:
+	static void InsertCallback(PluginCallbacks& callbacks, IPluginFunction* listener, int priority, float interval, bool stop)
+	{
+		auto iter = std::find_if(callbacks.begin(), callbacks.end(), [priority](const PluginCallback& callback)
+		{
+			return callback.priority < priority;
+		});
+
+		callbacks.insert(iter, { listener, priority, interval > 0.0f ? interval : 0.0f, stop });
+	}
+
+	/* Stable insertion sort, snapshots are small and we don't want to allocate */
+	static void SortCallbacks(CallbacksSnapshot& callbacks)
+	{
+		for (size_t i = 1; i < callbacks.size(); i++)
+		{
+			for (size_t j = i; j > 0 && callbacks[j - 1].priority < callbacks[j].priority; j--)
+				std::swap(callbacks[j - 1], callbacks[j]);
+		}
+	}
+
+	static void AppendCallbacks(CallbacksSnapshot& listeners, ActionHandlers& handlers, size_t vtableidx)
+	{
+		if (handlers.listeners == 0)
+			return;
+
+		PluginCallbacks* callbacks = handlers.Find(vtableidx);
+
+		if (callbacks == NULL)
+			return;
+
+		for (const PluginCallback& callback : *callbacks)
+			listeners.push_back(callback);
+	}
+
+	void BindNamedHandlers(Action* action, NamedHandlers* named);
+	void BindNamedHandlers(Action* action);
+	void UnbindNamedHandlers(Action* action);
+	void RemoveNamedListeners(IPluginContext* context);
+	void DestroyNamedHandlers(NamedHandlers* named);
+
+	bool RemoveListener(size_t vtableidx, Action* action, ActionHandlers& handlers, IPluginContext* context);
+	void RemoveListeners(Action* action, ActionHandlers& handlers, const std::bitset<SIZE>& mask, IPluginContext* context);
+
+	static inline IPluginContext* GetListenerContext(IPluginFunction* listener)
+	{
+		return listener->GetParentRuntime()->GetDefaultContext();
+	}
+
+	bool PassThrottle(Action* action, size_t vtableidx, const PluginCallback& callback, float now);
+	void RemoveThrottles(Action* action);
+	void RemoveThrottles(IPluginContext* context);
+
+	void IndexListener(size_t vtableidx, Action* action, IPluginContext* context);
+	void UnindexListener(Action* action, IPluginContext* context);
+	void UnindexAction(Action* action, ActionHandlers& handlers);
+
+	void OnListenerAdded(size_t vtableidx, Action* action, ActionHandlers& handlers);
+	void OnListenersRemoved(size_t vtableidx, Action* action, ActionHandlers& handlers, size_t count = 1);
+
 private:
 	ActionsHandler m_handlers;
+	ContextsIndex m_contexts;
+	Throttles m_throttles;
+	NamedHandlersMap m_named;
+	std::vector<NamedHandlers*> m_namedList;
+	NamedActions m_namedActions;
+	size_t m_listeners[SIZE];
+	bool m_post;
 	bool m_init;
 };
 
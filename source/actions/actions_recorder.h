@@ -0,0 +1,103 @@
+#pragma once
+
+#include "utils.h"
+
+#include "extension.h"
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+#include <am-hashmap.h>
+
+#include "NextBotBehavior.h"
+
+/*
+ * Fixed size ring buffer of action transitions, cheap enough to stay enabled.
+ * Records are written without allocations and dumped to file on demand with ext_actions_recorder_dump.
+ */
+class ActionsRecorder
+{
+public:
+	static constexpr size_t CAPACITY = 16384;
+	static constexpr uint32_t MAGIC = 0x52435841; // "AXCR"
+	static constexpr uint32_t VERSION = 1;
+
+	enum class RecordType : uint8_t
+	{
+		Added,
+		Removed,
+		Result,		// action returned change/suspend/done
+		Handler		// plugin changed handler result
+	};
+
+	struct Record
+	{
+		int32_t tick;
+		uint32_t nameId;
+		uint32_t targetId;	// name id of action we change/suspend to
+		uint16_t entity;
+		uint16_t plugin;	// index in plugins table, 0 - none
+		RecordType type;
+		uint8_t handler;	// vtable index
+		uint8_t result;		// ActionResultType for Result, ResultType for Handler
+		uint8_t post;
+	};
+
+	static_assert(sizeof(Record) == 20, "Record layout is part of binary dump format");
+
+public:
+	ActionsRecorder();
+
+	inline bool IsEnabled() const noexcept;
+
+	void OnActionAdded(cell_t entity, Action<void>* action);
+	void OnActionRemoved(cell_t entity, Action<void>* action);
+	void OnActionResult(Action<void>* action, size_t vtableidx, ActionResultType type, Action<void>* target);
+	void OnHandlerChanged(Action<void>* action, size_t vtableidx, bool post, ResultType result, IPluginFunction* changer);
+
+	void OnPluginUnloaded(IPluginRuntime* runtime);
+
+	size_t GetCount() const noexcept
+	{
+		return m_count;
+	}
+
+	void Clear() noexcept;
+
+	/* Oldest record first */
+	bool DumpCSV(const char* path) const;
+	bool DumpBinary(const char* path) const;
+
+private:
+	Record& Push(RecordType type, cell_t entity, Action<void>* action);
+	uint16_t GetPluginIndex(IPluginFunction* function);
+
+	template<typename F>
+	void ForEachRecord(F&& function) const
+	{
+		const size_t first = (m_next + CAPACITY - m_count) % CAPACITY;
+
+		for (size_t i = 0; i < m_count; i++)
+			function(m_records[(first + i) % CAPACITY]);
+	}
+
+private:
+	using PluginsIndex = ke::HashMap<IPluginRuntime*, uint16_t, ke::PointerPolicy<IPluginRuntime>>;
+
+	Record m_records[CAPACITY];
+	size_t m_next;
+	size_t m_count;
+
+	/* Names outlive plugins so old records stay readable after unload */
+	PluginsIndex m_plugins;
+	std::vector<std::string> m_pluginNames;
+};
+
+extern ConVar ext_actions_recorder;
+extern ActionsRecorder* g_pActionsRecorder;
+
+inline bool ActionsRecorder::IsEnabled() const noexcept
+{
+	return ext_actions_recorder.GetBool();
+}
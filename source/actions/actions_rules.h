@@ -0,0 +1,85 @@
+#pragma once
+
+#include "utils.h"
+
+#include "extension.h"
+
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "NextBotBehavior.h"
+
+struct ActionClass;
+
+/*
+ * Declarative replacement rules from configs/actions_rules.cfg, evaluated before plugin listeners.
+ * Matched handler is superceded with rule result, so trivial rules never enter VM.
+ */
+class ActionsRules
+{
+public:
+	static constexpr size_t SIZE = 100;
+
+	struct Rule
+	{
+		std::string name;					// section name, used in logs only
+		std::string handler;
+		uint32_t nameId;					// action name
+		uint32_t intentionId;				// intention type name, INVALID_NAME_ID - any
+		ActionResultType type;
+		EventResultPriorityType priority;	// event handlers only
+		const ActionClass* replacement;		// CHANGE_TO and SUSPEND_FOR
+		const char* reason;
+		uint64_t hits;
+	};
+
+public:
+	ActionsRules();
+	~ActionsRules();
+
+	/* Replaces current rules, old ones are kept if file can't be read */
+	bool Load();
+	void Clear();
+
+	inline bool HasRules(size_t vtableidx) const noexcept
+	{
+		return vtableidx < SIZE && m_mask.test(vtableidx);
+	}
+
+	template<typename T>
+	bool Apply(size_t vtableidx, Action<void>* action, T& result)
+	{
+		Rule* rule = Match(vtableidx, action);
+
+		if (rule == NULL)
+			return false;
+
+		result.m_type = rule->type;
+		result.m_action = CreateReplacement(rule);
+		result.m_reason = rule->reason;
+
+		if constexpr (std::is_same<T, EventDesiredResult<void>>::value)
+			result.m_priority = rule->priority;
+
+		return true;
+	}
+
+	void Dump() const;
+
+private:
+	Rule* Match(size_t vtableidx, Action<void>* action);
+	Action<void>* CreateReplacement(const Rule* rule);
+
+	bool Add(const char* handler, Rule& rule);
+	const char* StoreReason(const char* reason);
+
+private:
+	std::vector<Rule> m_rules[SIZE];
+	std::bitset<SIZE> m_mask;
+	/* Game keeps reason of pending result, strings have to survive reload */
+	std::vector<char*> m_reasons;
+};
+
+extern ActionsRules* g_pActionsRules;
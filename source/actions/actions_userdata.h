@@ -0,0 +1,65 @@
+#pragma once
+
+#include "utils.h"
+
+#include "extension.h"
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+#include <am-hashmap.h>
+#include <sm_stringhashmap.h>
+
+#include "NextBotBehavior.h"
+
+/*
+ * Plugin data attached to actions, freed together with action.
+ * Keys are interned once so per action lookups are integer compares.
+ */
+class ActionsUserData
+{
+	using Action = ::Action<void>;
+
+public:
+	enum class DataType : uint8_t
+	{
+		Cell,
+		Array,
+		String
+	};
+
+	struct Entry
+	{
+		uint32_t key;
+		DataType type;
+		cell_t value;
+		std::vector<cell_t> array;
+		std::string string;
+	};
+
+	using Entries = std::vector<Entry>;
+	using ActionsData = ke::HashMap<Action*, Entries, ke::PointerPolicy<Action>>;
+	using Keys = StringHashMap<uint32_t>;
+
+public:
+	ActionsUserData();
+
+	uint32_t InternKey(const char* key);
+	bool FindKey(const char* key, uint32_t* id);
+
+	Entry& Set(Action* action, uint32_t key, DataType type);
+	const Entry* Get(Action* action, uint32_t key) const;
+	bool Remove(Action* action, uint32_t key);
+
+	void OnActionDestroyed(Action* action);
+
+	size_t GetMemoryUsage() const;
+
+private:
+	Keys m_keys;
+	uint32_t m_nextKey;
+	mutable ActionsData m_data;
+};
+
+extern ActionsUserData* g_pActionsUserData;
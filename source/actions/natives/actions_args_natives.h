@@ -0,0 +1,158 @@
+#pragma once
+
+#include <basehandle.h>
+#include <iserverunknown.h>
+#include <KeyValues.h>
+
+/* Leading fields of CTakeDamageInfo (game/shared/takedamageinfo.h), same in both games */
+struct TakeDamageInfoLayout
+{
+	Vector m_vecDamageForce;
+	Vector m_vecDamagePosition;
+	Vector m_vecReportedPosition;
+	CBaseHandle m_hInflictor;
+	CBaseHandle m_hAttacker;
+	CBaseHandle m_hWeapon;
+	float m_flDamage;
+	float m_flMaxDamage;
+	float m_flBaseDamage;
+	int m_bitsDamageType;
+	int m_iDamageCustom;
+	int m_iDamageStats;
+	int m_iAmmoType;
+};
+
+template<typename T>
+static T* GetRuntimeArg(IPluginContext* pContext, cell_t arg)
+{
+	if (arg == 0 || g_pActionsManager->GetRuntimeArg() != (const void*)arg)
+	{
+		pContext->ReportError("Invalid handler argument passed %X. Check callback params.", arg);
+		return NULL;
+	}
+
+	return (T*)arg;
+}
+
+static cell_t HandleToEntity(const CBaseHandle& handle)
+{
+	if (!handle.IsValid())
+		return -1;
+
+	CBaseEntity* entity = gamehelpers->ReferenceToEntity(handle.GetEntryIndex());
+
+	/* Slot may be taken by another entity already, serial number tells them apart */
+	if (entity == NULL || reinterpret_cast<IServerUnknown*>(entity)->GetRefEHandle() != handle)
+		return -1;
+
+	return gamehelpers->EntityToBCompatRef(entity);
+}
+
+cell_t NAT_DamageInfoGetInflictor(IPluginContext* pContext, const cell_t* params)
+{
+	TakeDamageInfoLayout* info = GetRuntimeArg<TakeDamageInfoLayout>(pContext, params[1]);
+	return info ? HandleToEntity(info->m_hInflictor) : -1;
+}
+
+cell_t NAT_DamageInfoGetAttacker(IPluginContext* pContext, const cell_t* params)
+{
+	TakeDamageInfoLayout* info = GetRuntimeArg<TakeDamageInfoLayout>(pContext, params[1]);
+	return info ? HandleToEntity(info->m_hAttacker) : -1;
+}
+
+cell_t NAT_DamageInfoGetWeapon(IPluginContext* pContext, const cell_t* params)
+{
+	TakeDamageInfoLayout* info = GetRuntimeArg<TakeDamageInfoLayout>(pContext, params[1]);
+	return info ? HandleToEntity(info->m_hWeapon) : -1;
+}
+
+cell_t NAT_DamageInfoGetDamage(IPluginContext* pContext, const cell_t* params)
+{
+	TakeDamageInfoLayout* info = GetRuntimeArg<TakeDamageInfoLayout>(pContext, params[1]);
+	return info ? sp_ftoc(info->m_flDamage) : 0;
+}
+
+cell_t NAT_DamageInfoGetDamageType(IPluginContext* pContext, const cell_t* params)
+{
+	TakeDamageInfoLayout* info = GetRuntimeArg<TakeDamageInfoLayout>(pContext, params[1]);
+	return info ? info->m_bitsDamageType : 0;
+}
+
+template<Vector TakeDamageInfoLayout::*field>
+cell_t NAT_DamageInfoGetVector(IPluginContext* pContext, const cell_t* params)
+{
+	TakeDamageInfoLayout* info = GetRuntimeArg<TakeDamageInfoLayout>(pContext, params[1]);
+
+	if (info == NULL)
+		return 0;
+
+	cell_t* vec;
+	pContext->LocalToPhysAddr(params[2], &vec);
+
+	const Vector& value = info->*field;
+	vec[0] = sp_ftoc(value.x);
+	vec[1] = sp_ftoc(value.y);
+	vec[2] = sp_ftoc(value.z);
+	return 0;
+}
+
+cell_t NAT_KeyValuesGetString(IPluginContext* pContext, const cell_t* params)
+{
+	KeyValues* kv = GetRuntimeArg<KeyValues>(pContext, params[1]);
+
+	if (kv == NULL)
+		return 0;
+
+	char* key;
+	char* defvalue;
+
+	pContext->LocalToString(params[2], &key);
+	pContext->LocalToString(params[5], &defvalue);
+
+	size_t written = 0;
+	pContext->StringToLocalUTF8(params[3], params[4], kv->GetString(key, defvalue), &written);
+	return written;
+}
+
+cell_t NAT_KeyValuesGetNum(IPluginContext* pContext, const cell_t* params)
+{
+	KeyValues* kv = GetRuntimeArg<KeyValues>(pContext, params[1]);
+
+	if (kv == NULL)
+		return 0;
+
+	char* key;
+	pContext->LocalToString(params[2], &key);
+
+	return kv->GetInt(key, params[3]);
+}
+
+cell_t NAT_KeyValuesGetFloat(IPluginContext* pContext, const cell_t* params)
+{
+	KeyValues* kv = GetRuntimeArg<KeyValues>(pContext, params[1]);
+
+	if (kv == NULL)
+		return 0;
+
+	char* key;
+	pContext->LocalToString(params[2], &key);
+
+	return sp_ftoc(kv->GetFloat(key, sp_ctof(params[3])));
+}
+
+sp_nativeinfo_t g_ActionArgNatives[] =
+{
+	{ "ActionDamageInfo.Inflictor.get",			NAT_DamageInfoGetInflictor },
+	{ "ActionDamageInfo.Attacker.get",			NAT_DamageInfoGetAttacker },
+	{ "ActionDamageInfo.Weapon.get",			NAT_DamageInfoGetWeapon },
+	{ "ActionDamageInfo.Damage.get",			NAT_DamageInfoGetDamage },
+	{ "ActionDamageInfo.DamageType.get",		NAT_DamageInfoGetDamageType },
+	{ "ActionDamageInfo.GetDamageForce",		NAT_DamageInfoGetVector<&TakeDamageInfoLayout::m_vecDamageForce> },
+	{ "ActionDamageInfo.GetDamagePosition",		NAT_DamageInfoGetVector<&TakeDamageInfoLayout::m_vecDamagePosition> },
+
+	{ "ActionKeyValues.GetString",				NAT_KeyValuesGetString },
+	{ "ActionKeyValues.GetNum",					NAT_KeyValuesGetNum },
+	{ "ActionKeyValues.GetFloat",				NAT_KeyValuesGetFloat },
+
+	{ NULL, NULL }
+};
@@ -6,12 +6,105 @@ cell_t NAT_CreatePluginAction(IPluginContext* pContext, const cell_t* params)
 	
 	PluginAction* action = new PluginAction(name);
 	g_pActionsManager->AddPending(action);
+
+	/* Every plugin action shares our vtable, names can't be cached per vtable for them */
+	static bool dynamic = false;
+
+	if (!dynamic)
+	{
+		g_pActionsNames->AddDynamicVTable(*reinterpret_cast<void**>(action));
+		dynamic = true;
+	}
 		
-	return (cell_t)action;
+	return g_pActionsManager->ToCell(action);
+}
+
+cell_t NAT_RegisterActionClass(IPluginContext* pContext, const cell_t* params)
+{
+	char* name;
+	pContext->LocalToString(params[1], &name);
+
+	if (name[0] == '\0')
+	{
+		pContext->ReportError("Action class name can't be empty");
+		return 0;
+	}
+
+	return g_pActionClasses->Register(name);
+}
+
+cell_t NAT_CreateClassAction(IPluginContext* pContext, const cell_t* params)
+{
+	const ActionClass* actionClass = g_pActionClasses->Get(params[1]);
+
+	if (actionClass == NULL)
+	{
+		pContext->ReportError("Invalid action class %i", params[1]);
+		return 0;
+	}
+
+	return g_pActionsManager->ToCell(g_pActionClasses->Create(actionClass));
+}
+
+template<bool set>
+cell_t NAT_ActionClassHandler(IPluginContext* pContext, const cell_t* params)
+{
+	const ActionClass* actionClass = g_pActionClasses->Get(params[1]);
+
+	if (actionClass == NULL)
+	{
+		pContext->ReportError("Invalid action class %i", params[1]);
+		return 0;
+	}
+
+	char* handler;
+	pContext->LocalToString(params[2], &handler);
+
+	IPluginFunction* listener = pContext->GetFunctionById(params[3]);
+	ActionsPropagate* propagate = params[4] ? g_pActionsPropagatePost : g_pActionsPropagatePre;
+
+	if (listener == NULL)
+	{
+		pContext->ReportError("Invalid function id %X", params[3]);
+		return 0;
+	}
+
+	size_t vtableidx = GetListenableHandlerOffset(pContext, handler);
+
+	if (vtableidx == 0)
+		return 0;
+
+	/* Class handler table is the named listeners table of its name */
+	if constexpr (set)
+	{
+		return propagate->AddNamedListener(vtableidx, actionClass->name.c_str(), listener, params[5]);
+	}
+	else
+	{
+		return propagate->RemoveNamedListener(vtableidx, actionClass->name.c_str(), listener);
+	}
+}
+
+cell_t NAT_ActionClassNameId(IPluginContext* pContext, const cell_t* params)
+{
+	const ActionClass* actionClass = g_pActionClasses->Get(params[1]);
+
+	if (actionClass == NULL)
+	{
+		pContext->ReportError("Invalid action class %i", params[1]);
+		return 0;
+	}
+
+	return actionClass->nameId;
 }
 
 sp_nativeinfo_t g_ActionCustomNatives[] =
 {
 	{ "ActionsManager.Create", NAT_CreatePluginAction },
+	{ "ActionsManager.RegisterActionClass", NAT_RegisterActionClass },
+	{ "ActionClass.Create", NAT_CreateClassAction },
+	{ "ActionClass.SetHandler", NAT_ActionClassHandler<true> },
+	{ "ActionClass.RemoveHandler", NAT_ActionClassHandler<false> },
+	{ "ActionClass.NameId.get", NAT_ActionClassNameId },
 	{ NULL, NULL }
 };
\ No newline at end of file
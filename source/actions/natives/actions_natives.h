@@ -1,64 +1,87 @@
 #pragma once
 
+#include "actions_userdata.h"
+#include "actions_names.h"
+
+/* Must match ActionSnapshotField in actions.inc */
+enum ActionSnapshotField : cell_t
+{
+	SNAPSHOT_ACTION,
+	SNAPSHOT_NAME_ID,
+	SNAPSHOT_PARENT,
+	SNAPSHOT_CHILD,
+	SNAPSHOT_UNDER,
+	SNAPSHOT_ABOVE,
+	SNAPSHOT_FLAGS,
+
+	SNAPSHOT_FIELDS
+};
+
+enum : cell_t
+{
+	SNAPSHOT_FLAG_STARTED = (1 << 0),
+	SNAPSHOT_FLAG_SUSPENDED = (1 << 1)
+};
+
 cell_t NAT_GetActionParent(IPluginContext* pContext, const cell_t* params)
 {
-	Action<void>* action = (Action<void>*)params[1];
+	Action<void>* action = g_pActionsManager->ResolveAction(params[1]);
 
-	if (!g_pActionsManager->IsValidAction(action))
+	if (action == NULL)
 	{
-		pContext->ReportError("Invalid action passed %X", action);
+		pContext->ReportError("Invalid action passed %X", params[1]);
 		return 0;
 	}
 
-	return (cell_t)action->m_parent;
+	return g_pActionsManager->ToCell(action->m_parent);
 }
 
 cell_t NAT_GetActionChild(IPluginContext* pContext, const cell_t* params)
 {
-	Action<void>* action = (Action<void>*)params[1];
+	Action<void>* action = g_pActionsManager->ResolveAction(params[1]);
 
-	if (!g_pActionsManager->IsValidAction(action))
+	if (action == NULL)
 	{
-		pContext->ReportError("Invalid action passed %X", action);
+		pContext->ReportError("Invalid action passed %X", params[1]);
 		return 0;
 	}
 
-	return (cell_t)action->GetActiveChildAction();
+	return g_pActionsManager->ToCell(action->GetActiveChildAction());
 }
 
 cell_t NAT_GetActionUnder(IPluginContext* pContext, const cell_t* params)
 {
-	Action<void>* action = (Action<void>*)params[1];
+	Action<void>* action = g_pActionsManager->ResolveAction(params[1]);
 
-	if (!g_pActionsManager->IsValidAction(action))
+	if (action == NULL)
 	{
-		pContext->ReportError("Invalid action passed %X", action);
+		pContext->ReportError("Invalid action passed %X", params[1]);
 		return 0;
 	}
 
-	return (cell_t)action->GetActionBuriedUnderMe();
+	return g_pActionsManager->ToCell(action->GetActionBuriedUnderMe());
 }
 
 cell_t NAT_GetActionAbove(IPluginContext* pContext, const cell_t* params)
 {
-	Action<void>* action = (Action<void>*)params[1];
+	Action<void>* action = g_pActionsManager->ResolveAction(params[1]);
 
-	if (!g_pActionsManager->IsValidAction(action))
+	if (action == NULL)
 	{
-		pContext->ReportError("Invalid action passed %X", action);
+		pContext->ReportError("Invalid action passed %X", params[1]);
 		return 0;
 	}
 
-	return (cell_t)action->GetActionCoveringMe();
+	return g_pActionsManager->ToCell(action->GetActionCoveringMe());
 }
 
 cell_t NAT_GetActionActor(IPluginContext* pContext, const cell_t* params)
 {
-	Action<void>* action = (Action<void>*)params[1];
+	Action<void>* action = g_pActionsManager->ResolveAction(params[1]);
 
-	if (!g_pActionsManager->IsValidAction(action))
+	if (action == NULL)
 	{
-		pContext->ReportError("Invalid action passed %X", action);
+		pContext->ReportError("Invalid action passed %X", params[1]);
 		return 0;
 	}
 
@@ -71,11 +94,11 @@ cell_t NAT_GetActionActor(IPluginContext* pContext, const cell_t* params)
 
 cell_t NAT_ActionSuspend(IPluginContext* pContext, const cell_t* params)
 {
-	Action<void>* action = (Action<void>*)params[1];
+	Action<void>* action = g_pActionsManager->ResolveAction(params[1]);
 
-	if (!g_pActionsManager->IsValidAction(action))
+	if (action == NULL)
 	{
-		pContext->ReportError("Invalid action passed %X", action);
+		pContext->ReportError("Invalid action passed %X", params[1]);
 		return 0;
 	}
 
@@ -91,11 +114,11 @@ cell_t NAT_ActionSuspend(IPluginContext* pContext, const cell_t* params)
 
 cell_t NAT_ActionStarted(IPluginContext* pContext, const cell_t* params)
 {
-	Action<void>* action = (Action<void>*)params[1];
+	Action<void>* action = g_pActionsManager->ResolveAction(params[1]);
 
-	if (!g_pActionsManager->IsValidAction(action))
+	if (action == NULL)
 	{
-		pContext->ReportError("Invalid action passed %X", action);
+		pContext->ReportError("Invalid action passed %X", params[1]);
 		return 0;
 	}
 
@@ -111,11 +134,11 @@ cell_t NAT_ActionStarted(IPluginContext* pContext, const cell_t* params)
 
 cell_t NAT_GetActionName(IPluginContext* pContext, const cell_t* params)
 {
-	Action<void>* action = (Action<void>*)params[1];
+	Action<void>* action = g_pActionsManager->ResolveAction(params[1]);
 
-	if (!g_pActionsManager->IsValidAction(action))
+	if (action == NULL)
 	{
-		pContext->ReportError("Invalid action passed %X", action);
+		pContext->ReportError("Invalid action passed %X", params[1]);
 		return 0;
 	}
 
@@ -123,6 +146,19 @@ cell_t NAT_GetActionName(IPluginContext* pContext, const cell_t* params)
 	return pContext->StringToLocal(params[2], params[3], name);
 }
 
+cell_t NAT_GetActionAddress(IPluginContext* pContext, const cell_t* params)
+{
+	Action<void>* action = g_pActionsManager->ResolveAction(params[1]);
+
+	if (action == NULL)
+	{
+		pContext->ReportError("Invalid action passed %X", params[1]);
+		return 0;
+	}
+
+	return (cell_t)action;
+}
+
 cell_t NAT_GetEntityActions(IPluginContext* pContext, const cell_t* params)
 {
 	IPluginFunction* iterator = NULL;
@@ -137,7 +173,7 @@ cell_t NAT_GetEntityActions(IPluginContext* pContext, const cell_t* params)
 
 	for (auto action : actions)
 	{
-		iterator->PushCell((cell_t)action);
+		iterator->PushCell(g_pActionsManager->ToCell(action));
 		iterator->Execute(NULL);
 	}
 
@@ -146,33 +182,34 @@ cell_t NAT_GetEntityActions(IPluginContext* pContext, const cell_t* params)
 
 cell_t NAT_ActionsAllocate(IPluginContext* pContext, const cell_t* params)
 {
-	return (cell_t)::operator new((size_t)params[1]);
+	return (cell_t)g_pActionsPool->Alloc((size_t)params[1], true);
 }
 
 cell_t NAT_ActionsDeallocate(IPluginContext* pContext, const cell_t* params)
 {
-	Action<void>* action = (Action<void>*)params[1];
+	Action<void>* action = g_pActionsManager->ResolveAction(params[1]);
 
-	if (!g_pActionsManager->IsValidAction(action))
+	if (action == NULL)
 	{
-		pContext->ReportError("You are trying to delete invalid action %X", action);
+		pContext->ReportError("You are trying to delete invalid action %X", params[1]);
 		return 0;
 	}
 
 	if (g_pActionsManager->GetRuntimeAction() == action)
 		g_pActionsManager->SetRuntimeAction(NULL);
 
+	g_pActionsManager->RemovePending(action);
 	delete action;
 	return 0;
 }
 
 cell_t NAT_StorePendingEventResult(IPluginContext* pContext, const cell_t* params)
 {
-	Action<void>* action = (Action<void>*)params[1];
+	Action<void>* action = g_pActionsManager->ResolveAction(params[1]);
 
-	if (!g_pActionsManager->IsValidAction(action))
+	if (action == NULL)
 	{
-		pContext->ReportError("Invalid action passed %X", action);
+		pContext->ReportError("Invalid action passed %X", params[1]);
 		return 0;
 	}
 
@@ -182,7 +219,7 @@ cell_t NAT_StorePendingEventResult(IPluginContext* pContext, const cell_t* param
 	pContext->LocalToStringNULL(params[4], &reason);
 
 	result.m_type = (ActionResultType)params[2];
-	result.m_action = (Action<void>*)params[3];
+	result.m_action = g_pActionsManager->FromCell(params[3]);
 	result.m_reason = reason;
 	result.m_priority = (EventResultPriorityType)params[5];
 
@@ -204,24 +241,373 @@ cell_t NAT_GetEntityAction(IPluginContext* pContext, const cell_t* params)
 	if (num == 0)
 		return 0;
 
+	/* Name that was never interned matches no action, don't grow the table for it */
+	const uint32_t id = g_pActionsNames->Lookup(match);
+
+	if (id == ActionsNames::INVALID_NAME_ID)
+		return 0;
+
 	for(auto action : actions)
 	{
-		if (strcmp(action->GetName(), match) == 0)
-			return (cell_t)action;
+		if (g_pActionsNames->GetNameId(action) == id)
+			return g_pActionsManager->ToCell(action);
 	}
 
 	return 0;
 }
 
+cell_t NAT_GetEntitySnapshot(IPluginContext* pContext, const cell_t* params)
+{
+	/* Reused between calls, plugins tend to poll every bot each few frames */
+	static std::vector<Action<void>*> actions;
+
+	actions.clear();
+
+	size_t num = g_pActionsManager->GetEntityActions(params[1], &actions);
+
+	if (num == 0)
+		return 0;
+
+	cell_t* buffer;
+	pContext->LocalToPhysAddr(params[2], &buffer);
+
+	const size_t written = std::min(num, (size_t)std::max(params[3], 0) / SNAPSHOT_FIELDS);
+
+	auto indexOf = [written](Action<void>* relative) -> cell_t
+	{
+		if (relative == NULL)
+			return -1;
+
+		for (size_t i = 0; i < written; i++)
+		{
+			if (actions[i] == relative)
+				return (cell_t)i;
+		}
+
+		return -1;
+	};
+
+	for (size_t i = 0; i < written; i++)
+	{
+		Action<void>* action = actions[i];
+		cell_t* record = buffer + i * SNAPSHOT_FIELDS;
+
+		record[SNAPSHOT_ACTION] = g_pActionsManager->ToCell(action);
+		record[SNAPSHOT_NAME_ID] = g_pActionsNames->GetNameId(action);
+		record[SNAPSHOT_PARENT] = indexOf(action->m_parent);
+		record[SNAPSHOT_CHILD] = indexOf(action->m_child);
+		record[SNAPSHOT_UNDER] = indexOf(action->m_buriedUnderMe);
+		record[SNAPSHOT_ABOVE] = indexOf(action->m_coveringMe);
+		record[SNAPSHOT_FLAGS] = (action->m_isStarted ? SNAPSHOT_FLAG_STARTED : 0) | (action->m_isSuspended ? SNAPSHOT_FLAG_SUSPENDED : 0);
+	}
+
+	return num;
+}
+
+cell_t NAT_LookupNameId(IPluginContext* pContext, const cell_t* params)
+{
+	char* name;
+	pContext->LocalToString(params[1], &name);
+
+	return g_pActionsNames->Intern(name);
+}
+
+cell_t NAT_GetActionNameId(IPluginContext* pContext, const cell_t* params)
+{
+	Action<void>* action = g_pActionsManager->ResolveAction(params[1]);
+
+	if (action == NULL)
+	{
+		pContext->ReportError("Invalid action passed %X", params[1]);
+		return 0;
+	}
+
+	return g_pActionsNames->GetNameId(action);
+}
+
+cell_t NAT_GetNameById(IPluginContext* pContext, const cell_t* params)
+{
+	const char* name = g_pActionsNames->GetName(params[1]);
+
+	if (name == NULL)
+		return 0;
+
+	size_t written = 0;
+	pContext->StringToLocalUTF8(params[2], params[3], name, &written);
+	return written;
+}
+
+cell_t NAT_SetUserData(IPluginContext* pContext, const cell_t* params)
+{
+	Action<void>* action = g_pActionsManager->ResolveAction(params[1]);
+
+	if (action == NULL)
+	{
+		pContext->ReportError("Invalid action passed %X", params[1]);
+		return 0;
+	}
+
+	char* key;
+	pContext->LocalToString(params[2], &key);
+
+	ActionsUserData::Entry& entry = g_pActionsUserData->Set(action, g_pActionsUserData->InternKey(key), ActionsUserData::DataType::Cell);
+	entry.value = params[3];
+	return 0;
+}
+
+cell_t NAT_SetUserDataArray(IPluginContext* pContext, const cell_t* params)
+{
+	Action<void>* action = g_pActionsManager->ResolveAction(params[1]);
+
+	if (action == NULL)
+	{
+		pContext->ReportError("Invalid action passed %X", params[1]);
+		return 0;
+	}
+
+	if (params[4] < 0)
+	{
+		pContext->ReportError("Invalid array size %i", params[4]);
+		return 0;
+	}
+
+	char* key;
+	cell_t* array;
+
+	pContext->LocalToString(params[2], &key);
+	pContext->LocalToPhysAddr(params[3], &array);
+
+	ActionsUserData::Entry& entry = g_pActionsUserData->Set(action, g_pActionsUserData->InternKey(key), ActionsUserData::DataType::Array);
+	entry.array.assign(array, array + params[4]);
+	return 0;
+}
+
+cell_t NAT_SetUserDataString(IPluginContext* pContext, const cell_t* params)
+{
+	Action<void>* action = g_pActionsManager->ResolveAction(params[1]);
+
+	if (action == NULL)
+	{
+		pContext->ReportError("Invalid action passed %X", params[1]);
+		return 0;
+	}
+
+	char* key;
+	char* value;
+
+	pContext->LocalToString(params[2], &key);
+	pContext->LocalToString(params[3], &value);
+
+	ActionsUserData::Entry& entry = g_pActionsUserData->Set(action, g_pActionsUserData->InternKey(key), ActionsUserData::DataType::String);
+	entry.string = value;
+	return 0;
+}
+
+static const ActionsUserData::Entry* FindUserData(IPluginContext* pContext, const cell_t* params, Action<void>** action = NULL)
+{
+	Action<void>* target = g_pActionsManager->ResolveAction(params[1]);
+
+	if (target == NULL)
+	{
+		pContext->ReportError("Invalid action passed %X", params[1]);
+		return NULL;
+	}
+
+	if (action)
+		*action = target;
+
+	char* key;
+	uint32_t id;
+
+	pContext->LocalToString(params[2], &key);
+
+	/* Lookups don't intern, unknown key can't have data */
+	if (!g_pActionsUserData->FindKey(key, &id))
+		return NULL;
+
+	return g_pActionsUserData->Get(target, id);
+}
+
+cell_t NAT_GetUserData(IPluginContext* pContext, const cell_t* params)
+{
+	const ActionsUserData::Entry* entry = FindUserData(pContext, params);
+
+	if (entry == NULL || entry->type != ActionsUserData::DataType::Cell)
+		return params[3];
+
+	return entry->value;
+}
+
+cell_t NAT_GetUserDataArray(IPluginContext* pContext, const cell_t* params)
+{
+	const ActionsUserData::Entry* entry = FindUserData(pContext, params);
+
+	if (entry == NULL || entry->type != ActionsUserData::DataType::Array)
+		return 0;
+
+	cell_t* array;
+	pContext->LocalToPhysAddr(params[3], &array);
+
+	size_t count = std::min(entry->array.size(), (size_t)std::max(params[4], 0));
+	memcpy(array, entry->array.data(), count * sizeof(cell_t));
+	return count;
+}
+
+cell_t NAT_GetUserDataString(IPluginContext* pContext, const cell_t* params)
+{
+	const ActionsUserData::Entry* entry = FindUserData(pContext, params);
+
+	if (entry == NULL || entry->type != ActionsUserData::DataType::String)
+		return 0;
+
+	size_t written = 0;
+	pContext->StringToLocalUTF8(params[3], params[4], entry->string.c_str(), &written);
+	return written;
+}
+
+cell_t NAT_HasUserData(IPluginContext* pContext, const cell_t* params)
+{
+	return FindUserData(pContext, params) != NULL;
+}
+
+cell_t NAT_RemoveUserData(IPluginContext* pContext, const cell_t* params)
+{
+	Action<void>* action = NULL;
+
+	if (FindUserData(pContext, params, &action) == NULL)
+		return 0;
+
+	char* key;
+	uint32_t id;
+
+	pContext->LocalToString(params[2], &key);
+	g_pActionsUserData->FindKey(key, &id);
+
+	return g_pActionsUserData->Remove(action, id);
+}
+
+template<bool watch, bool destroyed>
+cell_t NAT_WatchActions(IPluginContext* pContext, const cell_t* params)
+{
+	char* name;
+	pContext->LocalToString(params[1], &name);
+
+	IPluginFunction* callback = pContext->GetFunctionById(params[2]);
+
+	if (callback == NULL)
+	{
+		pContext->ReportError("Invalid function id %X", params[2]);
+		return 0;
+	}
+
+	if constexpr (watch)
+	{
+		return g_pActionsManager->AddWatcher(name, callback, destroyed);
+	}
+	else
+	{
+		return g_pActionsManager->RemoveWatcher(name, callback, destroyed);
+	}
+}
+
+cell_t NAT_GetCensus(IPluginContext* pContext, const cell_t* params)
+{
+	uint32_t nameId = static_cast<uint32_t>(params[1]);
+
+	if (nameId != ActionsNames::INVALID_NAME_ID && g_pActionsNames->GetName(nameId) == NULL)
+	{
+		pContext->ReportError("Invalid name id %i", params[1]);
+		return 0;
+	}
+
+	ActionsManager::CensusCounters counters;
+	bool found = g_pActionsManager->GetCensus(nameId, counters);
+
+	cell_t* live, *peak, *created, *pending;
+	pContext->LocalToPhysAddr(params[2], &live);
+	pContext->LocalToPhysAddr(params[3], &peak);
+	pContext->LocalToPhysAddr(params[4], &created);
+	pContext->LocalToPhysAddr(params[5], &pending);
+
+	*live = counters.live;
+	*peak = counters.peak;
+	*created = counters.created > INT32_MAX ? INT32_MAX : static_cast<cell_t>(counters.created);
+	*pending = counters.pending;
+	return found;
+}
+
+cell_t NAT_WatchChanged(IPluginContext* pContext, const cell_t* params)
+{
+	IPluginFunction* callback = pContext->GetFunctionById(params[1]);
+
+	if (callback == NULL)
+	{
+		pContext->ReportError("Invalid function id %X", params[1]);
+		return 0;
+	}
+
+	cell_t entity = params[2];
+
+	if (entity != -1 && (entity < 0 || entity >= ActionsManager::MAX_ENTITIES))
+	{
+		pContext->ReportError("Invalid entity %i", entity);
+		return 0;
+	}
+
+	uint32_t nameId = static_cast<uint32_t>(params[3]);
+
+	if (nameId != ActionsNames::INVALID_NAME_ID && g_pActionsNames->GetName(nameId) == NULL)
+	{
+		pContext->ReportError("Invalid name id %i", params[3]);
+		return 0;
+	}
+
+	return g_pActionsManager->AddChangeWatcher(callback, entity, nameId);
+}
+
+cell_t NAT_UnwatchChanged(IPluginContext* pContext, const cell_t* params)
+{
+	IPluginFunction* callback = pContext->GetFunctionById(params[1]);
+
+	if (callback == NULL)
+	{
+		pContext->ReportError("Invalid function id %X", params[1]);
+		return 0;
+	}
+
+	return g_pActionsManager->RemoveChangeWatcher(callback);
+}
+
 sp_nativeinfo_t g_ActionNatives[] =
 {
 	{ "ActionsManager.Allocate", NAT_ActionsAllocate },
 	{ "ActionsManager.Deallocate", NAT_ActionsDeallocate },
 	{ "ActionsManager.Iterator", NAT_GetEntityActions },
 	{ "ActionsManager.GetAction", NAT_GetEntityAction },
+	{ "ActionsManager.Snapshot", NAT_GetEntitySnapshot },
+	{ "ActionsManager.GetNameById", NAT_GetNameById },
+	{ "ActionsManager.LookupNameId", NAT_LookupNameId },
+	{ "ActionsManager.WatchCreated", NAT_WatchActions<true, false> },
+	{ "ActionsManager.WatchDestroyed", NAT_WatchActions<true, true> },
+	{ "ActionsManager.UnwatchCreated", NAT_WatchActions<false, false> },
+	{ "ActionsManager.UnwatchDestroyed", NAT_WatchActions<false, true> },
+	{ "ActionsManager.WatchChanged", NAT_WatchChanged },
+	{ "ActionsManager.GetCensus", NAT_GetCensus },
+	{ "ActionsManager.UnwatchChanged", NAT_UnwatchChanged },
 
 	{ "BehaviorAction.StorePendingEventResult", NAT_StorePendingEventResult },
 	{ "BehaviorAction.GetName", NAT_GetActionName },
+	{ "BehaviorAction.GetAddress", NAT_GetActionAddress },
+	{ "BehaviorAction.NameId.get", NAT_GetActionNameId },
+
+	{ "BehaviorAction.SetUserData", NAT_SetUserData },
+	{ "BehaviorAction.GetUserData", NAT_GetUserData },
+	{ "BehaviorAction.SetUserDataArray", NAT_SetUserDataArray },
+	{ "BehaviorAction.GetUserDataArray", NAT_GetUserDataArray },
+	{ "BehaviorAction.SetUserDataString", NAT_SetUserDataString },
+	{ "BehaviorAction.GetUserDataString", NAT_GetUserDataString },
+	{ "BehaviorAction.HasUserData", NAT_HasUserData },
+	{ "BehaviorAction.RemoveUserData", NAT_RemoveUserData },
 
 	{ "BehaviorAction.Parent.get", NAT_GetActionParent },
 	{ "BehaviorAction.Child.get", NAT_GetActionChild },
@@ -3,22 +3,20 @@
 template<bool post, const char ... s>
 cell_t NAT_ActionHandler(IPluginContext* pContext, const cell_t* params)
 {
-	std::map<std::string, size_t>& offsets = GetOffsetsInfo();
-	Action<void>* action = (Action<void>*)params[1];
-	std::string name;
-	size_t vtableidx = 0;
+	static constexpr char name[] = { s..., '\0' };
+	static size_t vtableidx = 0;
 
+	Action<void>* action = g_pActionsManager->ResolveAction(params[1]);
 	IPluginFunction* listener = NULL;
 	ActionsPropagate* propagate = NULL;
 
-	if (!g_pActionsManager->IsValidAction(action))
+	if (action == NULL)
 	{
-		pContext->ReportError("Invalid action passed %X", action);
+		pContext->ReportError("Invalid action passed %X", params[1]);
 		return 0;
 	}
 
 	listener = pContext->GetFunctionById(params[2]);
-	((name += s), ...);
 
 	if constexpr (!post)	
 	{
@@ -29,19 +27,12 @@ cell_t NAT_ActionHandler(IPluginContext* pContext, const cell_t* params)
 		propagate = g_pActionsPropagatePost;
 	}
 
-	//vtableidx = offsets[name];
-	for (auto iter = offsets.cbegin(); iter != offsets.cend(); iter++)
-	{
-		if (iter->first.find(name) != std::string::npos)
-		{
-			vtableidx = iter->second;
-			break;
-		}
-	}
+	if (vtableidx == 0)
+		vtableidx = GetHandlerOffset(name);
 
 	if (vtableidx == 0)
 	{
-		pContext->ReportFatalError("Failed to find function vtableidx \"%s\"", name.c_str());
+		pContext->ReportFatalError("Failed to find function vtableidx \"%s\"", name);
 		return 0;
 	}
 
@@ -49,7 +40,7 @@ cell_t NAT_ActionHandler(IPluginContext* pContext, const cell_t* params)
 	{
 		if (!propagate->RemoveListener(vtableidx, action, pContext))
 		{
-			// pContext->ReportError("You don't have any listener for %s", name.c_str());
+			// pContext->ReportError("You don't have any listener for %s", name);
 			return 0;
 		}
 	}
@@ -57,7 +48,7 @@ cell_t NAT_ActionHandler(IPluginContext* pContext, const cell_t* params)
 	{
 		if (!propagate->AddListener(vtableidx, action, listener))
 		{
-			// pContext->ReportError("You already have listener for %s", name.c_str());
+			// pContext->ReportError("You already have listener for %s", name);
 			return 0;
 		}
 	}
@@ -65,6 +56,113 @@ cell_t NAT_ActionHandler(IPluginContext* pContext, const cell_t* params)
 	return 1;
 }
 
+template<bool hook>
+cell_t NAT_HookByName(IPluginContext* pContext, const cell_t* params)
+{
+	char* name;
+	char* handler;
+
+	pContext->LocalToString(params[1], &name);
+	pContext->LocalToString(params[2], &handler);
+
+	IPluginFunction* listener = pContext->GetFunctionById(params[3]);
+	ActionsPropagate* propagate = params[4] ? g_pActionsPropagatePost : g_pActionsPropagatePre;
+
+	if (listener == NULL)
+	{
+		pContext->ReportError("Invalid function id %X", params[3]);
+		return 0;
+	}
+
+	size_t vtableidx = GetListenableHandlerOffset(pContext, handler);
+
+	if (vtableidx == 0)
+		return 0;
+
+	if constexpr (hook)
+	{
+		/* Priority, interval and stop were added later, older plugins pass 4 params */
+		int priority = params[0] >= 5 ? params[5] : 0;
+		float interval = params[0] >= 6 ? sp_ctof(params[6]) : 0.0f;
+		bool stop = params[0] >= 7 && params[7] != 0;
+		return propagate->AddNamedListener(vtableidx, name, listener, priority, interval, stop);
+	}
+	else
+	{
+		return propagate->RemoveNamedListener(vtableidx, name, listener);
+	}
+}
+
+template<bool hook>
+cell_t NAT_ActionHook(IPluginContext* pContext, const cell_t* params)
+{
+	Action<void>* action = g_pActionsManager->ResolveAction(params[1]);
+
+	if (action == NULL)
+	{
+		pContext->ReportError("Invalid action passed %X", params[1]);
+		return 0;
+	}
+
+	char* handler;
+	pContext->LocalToString(params[2], &handler);
+
+	IPluginFunction* listener = pContext->GetFunctionById(params[3]);
+	ActionsPropagate* propagate = params[4] ? g_pActionsPropagatePost : g_pActionsPropagatePre;
+
+	if (listener == NULL)
+	{
+		pContext->ReportError("Invalid function id %X", params[3]);
+		return 0;
+	}
+
+	size_t vtableidx = GetListenableHandlerOffset(pContext, handler);
+
+	if (vtableidx == 0)
+		return 0;
+
+	if constexpr (hook)
+	{
+		float interval = params[0] >= 6 ? sp_ctof(params[6]) : 0.0f;
+		bool stop = params[0] >= 7 && params[7] != 0;
+		return propagate->AddListener(vtableidx, action, listener, params[5], interval, stop);
+	}
+	else
+	{
+		return propagate->RemoveListener(vtableidx, action, listener);
+	}
+}
+
+template<bool hook>
+cell_t NAT_HookBatch(IPluginContext* pContext, const cell_t* params)
+{
+	char* handler;
+	pContext->LocalToString(params[1], &handler);
+
+	IPluginFunction* listener = pContext->GetFunctionById(params[2]);
+
+	if (listener == NULL)
+	{
+		pContext->ReportError("Invalid function id %X", params[2]);
+		return 0;
+	}
+
+	if (!ActionsBatch::IsSupported(handler))
+	{
+		pContext->ReportError("Event handler \"%s\" can't be batched", handler);
+		return 0;
+	}
+
+	if constexpr (hook)
+	{
+		return g_pActionsBatch->AddListener(handler, listener);
+	}
+	else
+	{
+		return g_pActionsBatch->RemoveListener(handler, listener);
+	}
+}
+
 cell_t NAT_ActionResultGetReason(IPluginContext* pContext, const cell_t* params)
 {
 	ActionResult<void>* actionResult = (ActionResult<void>*)params[1];
@@ -130,10 +228,10 @@ cell_t NAT_ActionActionType(IPluginContext* pContext, const cell_t* params)
 
 	if (params[0] > 1)
 	{
-		actionResult->m_action = (Action<void>*)params[2];
+		actionResult->m_action = g_pActionsManager->FromCell(params[2]);
 	}
 
-	return (cell_t)action;
+	return g_pActionsManager->ToCell(action);
 }
 
 cell_t NAT_ActionPriorityType(IPluginContext* pContext, const cell_t* params)
@@ -194,8 +292,8 @@ sp_nativeinfo_t g_ActionProcessorNatives[] =
 	{ "BehaviorAction.OnHitByVomitJar.set", 						NAT_ActionHandler<false, 'O', 'n', 'H', 'i', 't', 'B', 'y', 'V', 'o', 'm', 'i', 't', 'J', 'a', 'r'> },
 	{ "BehaviorAction.OnCommandAttack.set", 						NAT_ActionHandler<false, 'O', 'n', 'C', 'o', 'm', 'm', 'a', 'n', 'd', 'A', 't', 't', 'a', 'c', 'k'> },
 	{ "BehaviorAction.OnCommandAssault.set", 						NAT_ActionHandler<false, 'O', 'n', 'C', 'o', 'm', 'm', 'a', 'n', 'd', 'A', 's', 's', 'a', 'u', 'l', 't'> },
-	{ "BehaviorAction.OnCommandApproachV.set", 						NAT_ActionHandler<false, 'O', 'n', 'C', 'o', 'm', 'm', 'a', 'n', 'd', 'A', 'p', 'p', 'r', 'o', 'a', 'c', 'h', 'V'> },
-	{ "BehaviorAction.OnCommandApproachE.set", 						NAT_ActionHandler<false, 'O', 'n', 'C', 'o', 'm', 'm', 'a', 'n', 'd', 'A', 'p', 'p', 'r', 'o', 'a', 'c', 'h', 'E'> },
+	{ "BehaviorAction.OnCommandApproachV.set", 						NAT_ActionHandler<false, 'O', 'n', 'C', 'o', 'm', 'm', 'a', 'n', 'd', 'A', 'p', 'p', 'r', 'o', 'a', 'c', 'h', 'V', 'e', 'c', 't', 'o', 'r'> },
+	{ "BehaviorAction.OnCommandApproachE.set", 						NAT_ActionHandler<false, 'O', 'n', 'C', 'o', 'm', 'm', 'a', 'n', 'd', 'A', 'p', 'p', 'r', 'o', 'a', 'c', 'h', 'E', 'n', 't', 'i', 't', 'y'> },
 	{ "BehaviorAction.OnCommandRetreat.set", 						NAT_ActionHandler<false, 'O', 'n', 'C', 'o', 'm', 'm', 'a', 'n', 'd', 'R', 'e', 't', 'r', 'e', 'a', 't'> },
 	{ "BehaviorAction.OnCommandPause.set", 							NAT_ActionHandler<false, 'O', 'n', 'C', 'o', 'm', 'm', 'a', 'n', 'd', 'P', 'a', 'u', 's', 'e'> },
 	{ "BehaviorAction.OnCommandResume.set", 						NAT_ActionHandler<false, 'O', 'n', 'C', 'o', 'm', 'm', 'a', 'n', 'd', 'R', 'e', 's', 'u', 'm', 'e'> },
@@ -238,8 +336,8 @@ sp_nativeinfo_t g_ActionProcessorNatives[] =
 	{ "BehaviorAction.OnHitByVomitJarPost.set", 					NAT_ActionHandler<true, 'O', 'n', 'H', 'i', 't', 'B', 'y', 'V', 'o', 'm', 'i', 't', 'J', 'a', 'r'> },
 	{ "BehaviorAction.OnCommandAttackPost.set", 					NAT_ActionHandler<true, 'O', 'n', 'C', 'o', 'm', 'm', 'a', 'n', 'd', 'A', 't', 't', 'a', 'c', 'k'> },
 	{ "BehaviorAction.OnCommandAssaultPost.set", 					NAT_ActionHandler<true, 'O', 'n', 'C', 'o', 'm', 'm', 'a', 'n', 'd', 'A', 's', 's', 'a', 'u', 'l', 't'> },
-	{ "BehaviorAction.OnCommandApproachVPost.set", 					NAT_ActionHandler<true, 'O', 'n', 'C', 'o', 'm', 'm', 'a', 'n', 'd', 'A', 'p', 'p', 'r', 'o', 'a', 'c', 'h', 'V'> },
-	{ "BehaviorAction.OnCommandApproachEPost.set", 					NAT_ActionHandler<true, 'O', 'n', 'C', 'o', 'm', 'm', 'a', 'n', 'd', 'A', 'p', 'p', 'r', 'o', 'a', 'c', 'h', 'E'> },
+	{ "BehaviorAction.OnCommandApproachVPost.set", 					NAT_ActionHandler<true, 'O', 'n', 'C', 'o', 'm', 'm', 'a', 'n', 'd', 'A', 'p', 'p', 'r', 'o', 'a', 'c', 'h', 'V', 'e', 'c', 't', 'o', 'r'> },
+	{ "BehaviorAction.OnCommandApproachEPost.set", 					NAT_ActionHandler<true, 'O', 'n', 'C', 'o', 'm', 'm', 'a', 'n', 'd', 'A', 'p', 'p', 'r', 'o', 'a', 'c', 'h', 'E', 'n', 't', 'i', 't', 'y'> },
 	{ "BehaviorAction.OnCommandRetreatPost.set", 					NAT_ActionHandler<true, 'O', 'n', 'C', 'o', 'm', 'm', 'a', 'n', 'd', 'R', 'e', 't', 'r', 'e', 'a', 't'> },
 	{ "BehaviorAction.OnCommandPausePost.set", 						NAT_ActionHandler<true, 'O', 'n', 'C', 'o', 'm', 'm', 'a', 'n', 'd', 'P', 'a', 'u', 's', 'e'> },
 	{ "BehaviorAction.OnCommandResumePost.set", 					NAT_ActionHandler<true, 'O', 'n', 'C', 'o', 'm', 'm', 'a', 'n', 'd', 'R', 'e', 's', 'u', 'm', 'e'> },
@@ -258,5 +356,14 @@ sp_nativeinfo_t g_ActionProcessorNatives[] =
 	{ "ActionDesiredResult.priority.set",							NAT_ActionPriorityType },
 	{ "ActionDesiredResult.priority.get",							NAT_ActionPriorityType },
 
+	{ "ActionsManager.HookByName",									NAT_HookByName<true> },
+	{ "ActionsManager.UnhookByName",								NAT_HookByName<false> },
+
+	{ "ActionsManager.HookBatch",									NAT_HookBatch<true> },
+	{ "ActionsManager.UnhookBatch",									NAT_HookBatch<false> },
+
+	{ "BehaviorAction.Hook",										NAT_ActionHook<true> },
+	{ "BehaviorAction.Unhook",										NAT_ActionHook<false> },
+
 	{ NULL, NULL }
 };
\ No newline at end of file
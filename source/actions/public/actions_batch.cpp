@@ -0,0 +1,224 @@
+#include <algorithm>
+
+#include "actions_batch.h"
+#include "actions_processor.h"
+
+ActionsBatch g_ActionsBatch;
+ActionsBatch* g_pActionsBatch = &g_ActionsBatch;
+
+/* Handlers observers usually only count or log, all of them fire in bursts */
+static const char* s_batchedHandlers[] =
+{
+	"OnSight",
+	"OnLostSight",
+	"OnSound",
+	"OnContact"
+};
+
+ActionsBatch::ActionsBatch() : m_batched()
+{
+	m_queued.init();
+}
+
+bool ActionsBatch::IsSupported(const char* handler)
+{
+	for (const char* name : s_batchedHandlers)
+	{
+		if (strcmp(name, handler) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+ActionsBatch::Batch* ActionsBatch::Find(size_t vtableidx)
+{
+	for (Batch& batch : m_batches)
+	{
+		if (batch.vtableidx == vtableidx)
+			return &batch;
+	}
+
+	return NULL;
+}
+
+bool ActionsBatch::AddListener(const char* handler, IPluginFunction* callback)
+{
+	size_t vtableidx = GetHandlerOffset(handler);
+
+	if (vtableidx == 0 || vtableidx >= SIZE || !IsSupported(handler))
+		return false;
+
+	Batch* batch = Find(vtableidx);
+
+	if (batch == NULL)
+	{
+		/* Name has to outlive plugin, take it from our table */
+		const char* name = *std::find_if(std::begin(s_batchedHandlers), std::end(s_batchedHandlers), [handler](const char* name)
+		{
+			return strcmp(name, handler) == 0;
+		});
+
+		m_batches.push_back({ vtableidx, name, {}, {}, 0 });
+		batch = &m_batches.back();
+	}
+	else if (std::find(batch->callbacks.begin(), batch->callbacks.end(), callback) != batch->callbacks.end())
+	{
+		return false;
+	}
+
+	if (batch->callbacks.empty())
+	{
+		batch->events.reserve(64 * FIELDS);
+		m_batched.set(vtableidx);
+		ActionProcessor::RequestHandler(vtableidx, true);
+	}
+
+	batch->callbacks.push_back(callback);
+	return true;
+}
+
+bool ActionsBatch::RemoveListener(const char* handler, IPluginFunction* callback)
+{
+	Batch* batch = Find(GetHandlerOffset(handler));
+
+	if (batch == NULL)
+		return false;
+
+	auto iter = std::find(batch->callbacks.begin(), batch->callbacks.end(), callback);
+
+	if (iter == batch->callbacks.end())
+		return false;
+
+	batch->callbacks.erase(iter);
+
+	if (batch->callbacks.empty())
+	{
+		batch->events.clear();
+		m_batched.reset(batch->vtableidx);
+		ActionProcessor::ReleaseHandler(batch->vtableidx, true);
+
+		if (m_batched.none())
+			m_queued.clear();
+	}
+
+	return true;
+}
+
+void ActionsBatch::RemoveListeners(IPluginContext* context)
+{
+	for (Batch& batch : m_batches)
+	{
+		if (batch.callbacks.empty())
+			continue;
+
+		batch.callbacks.erase(std::remove_if(batch.callbacks.begin(), batch.callbacks.end(), [context](IPluginFunction* callback)
+		{
+			return callback->GetParentRuntime()->GetDefaultContext() == context;
+		}), batch.callbacks.end());
+
+		if (!batch.callbacks.empty())
+			continue;
+
+		batch.events.clear();
+		m_batched.reset(batch.vtableidx);
+		ActionProcessor::ReleaseHandler(batch.vtableidx, true);
+	}
+
+	/* Nothing delivers the remaining records */
+	if (m_batched.none())
+		m_queued.clear();
+}
+
+cell_t* ActionsBatch::Reserve(size_t vtableidx)
+{
+	Batch* batch = Find(vtableidx);
+
+	if (batch == NULL)
+		return NULL;
+
+	if (batch->events.size() >= MAX_EVENTS * FIELDS)
+	{
+		batch->dropped++;
+		return NULL;
+	}
+
+	batch->events.resize(batch->events.size() + FIELDS);
+	return &batch->events[batch->events.size() - FIELDS];
+}
+
+void ActionsBatch::OnActionDestroyed(Action<void>* action)
+{
+	if (m_batched.none())
+		return;
+
+	auto r = m_queued.find(action);
+
+	if (!r.found())
+		return;
+
+	m_queued.remove(r);
+
+	/* Records hold whatever ToCell gave while action was alive, handle or raw address */
+	const cell_t address = (cell_t)(intptr_t)action;
+	const cell_t cell = g_pActionsManager->ToCell(action);
+
+	for (Batch& batch : m_batches)
+	{
+		for (size_t i = FIELD_ACTION; i < batch.events.size(); i += FIELDS)
+		{
+			if (batch.events[i] == address || batch.events[i] == cell)
+				batch.events[i] = 0;
+		}
+	}
+}
+
+void ActionsBatch::OnGameFrame(bool simulating)
+{
+	g_pActionsBatch->Deliver();
+}
+
+void ActionsBatch::Deliver()
+{
+	if (m_batched.none())
+		return;
+
+	/* Every queued record is taken below, ones appended from callbacks are added again */
+	m_queued.clear();
+
+	/* Callbacks may unhook or hook perception handlers, batches are addressed by index */
+	std::vector<cell_t> events;
+
+	for (size_t i = 0; i < m_batches.size(); i++)
+	{
+		if (m_batches[i].events.empty())
+			continue;
+
+		/* Events appended from callbacks go to next frame */
+		events.swap(m_batches[i].events);
+
+		if (m_batches[i].dropped != 0)
+		{
+			LOGDEBUG("ActionsBatch: dropped %i %s events", m_batches[i].dropped, m_batches[i].handler);
+			m_batches[i].dropped = 0;
+		}
+
+		const char* handler = m_batches[i].handler;
+		const cell_t count = static_cast<cell_t>(events.size() / FIELDS);
+		std::vector<IPluginFunction*> callbacks = m_batches[i].callbacks;
+
+		for (IPluginFunction* callback : callbacks)
+		{
+			callback->PushString(handler);
+			callback->PushArray(events.data(), static_cast<unsigned int>(events.size()));
+			callback->PushCell(count);
+			callback->Execute(NULL);
+		}
+
+		/* Keep capacity of the bigger one for next frame */
+		if (m_batches[i].events.empty())
+			m_batches[i].events.swap(events);
+
+		events.clear();
+	}
+}
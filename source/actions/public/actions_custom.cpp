@@ -0,0 +1,59 @@
+#include "extension.h"
+
+#include "actions_manager.h"
+#include "actions_names.h"
+#include "actions_custom.h"
+
+ActionClasses g_ActionClasses;
+ActionClasses* g_pActionClasses = &g_ActionClasses;
+
+ActionClasses::~ActionClasses()
+{
+	for (ActionClass* actionClass : m_classes)
+		delete actionClass;
+
+	m_classes.clear();
+}
+
+cell_t ActionClasses::Register(const char* name)
+{
+	const uint32_t nameId = g_pActionsNames->Intern(name);
+
+	for (size_t i = 0; i < m_classes.size(); i++)
+	{
+		if (m_classes[i]->nameId == nameId)
+			return static_cast<cell_t>(i + 1);
+	}
+
+	ActionClass* actionClass = new ActionClass();
+	actionClass->name = name;
+	actionClass->nameId = nameId;
+
+	m_classes.push_back(actionClass);
+	return static_cast<cell_t>(m_classes.size());
+}
+
+const ActionClass* ActionClasses::Get(cell_t id) const
+{
+	if (id <= 0 || static_cast<size_t>(id) > m_classes.size())
+		return NULL;
+
+	return m_classes[id - 1];
+}
+
+ClassAction* ActionClasses::Create(const ActionClass* actionClass)
+{
+	ClassAction* action = new ClassAction(actionClass);
+	g_pActionsManager->AddPending(action);
+
+	/* Instances of every class share our vtable, same as plugin actions */
+	static bool dynamic = false;
+
+	if (!dynamic)
+	{
+		g_pActionsNames->AddDynamicVTable(*reinterpret_cast<void**>(action));
+		dynamic = true;
+	}
+
+	return action;
+}
@@ -0,0 +1,66 @@
+#include "extension.h"
+#include "actions_handles.h"
+
+ActionHandles::ActionHandles()
+{
+	if (!m_index.init())
+	{
+		LOGERROR("Failed to init ActionHandles");
+	}
+}
+
+cell_t ActionHandles::Acquire(Action* action)
+{
+	auto i = m_index.findForAdd(action);
+
+	if (i.found())
+		return MakeHandle(i->value, m_slots[i->value].generation);
+
+	uint32_t index;
+
+	if (!m_free.empty())
+	{
+		index = m_free.back();
+		m_free.pop_back();
+	}
+	else
+	{
+		if (m_slots.size() >= MAX_HANDLES)
+			return 0;
+
+		index = static_cast<uint32_t>(m_slots.size());
+		m_slots.push_back({ NULL, 0 });
+	}
+
+	m_slots[index].action = action;
+	m_index.add(i, action, index);
+	return MakeHandle(index, m_slots[index].generation);
+}
+
+cell_t ActionHandles::Find(Action* action) const
+{
+	auto r = m_index.find(action);
+
+	if (!r.found())
+		return 0;
+
+	return MakeHandle(r->value, m_slots[r->value].generation);
+}
+
+void ActionHandles::Release(Action* action)
+{
+	if (m_index.elements() == 0)
+		return;
+
+	auto r = m_index.find(action);
+
+	if (!r.found())
+		return;
+
+	Slot& slot = m_slots[r->value];
+	slot.action = NULL;
+	slot.generation = (slot.generation + 1) & GENERATION_MASK;
+
+	m_free.push_back(r->value);
+	m_index.remove(r);
+}
@@ -0,0 +1,246 @@
+#include <chrono>
+
+#include "actions_log.h"
+
+ActionsLog g_ActionsLog;
+ActionsLog* g_pActionsLog = &g_ActionsLog;
+
+ConVar ext_actions_log_async("ext_actions_log_async", "0", FCVAR_NONE, "Write LOG and debug output to logs/actions.log from background thread, errors still go to SourceMod logs");
+
+void ActionsLogMessage(const char* fmt, ...)
+{
+	va_list ap;
+	va_start(ap, fmt);
+	g_pActionsLog->Message(fmt, ap);
+	va_end(ap);
+}
+
+ActionsLog::ActionsLog() : m_head(0), m_tail(0), m_dropped(0), m_running(false), m_file(NULL), m_fileSize(0), m_written(0), m_truncated(0)
+{
+	m_path[0] = '\0';
+}
+
+ActionsLog::~ActionsLog()
+{
+	Stop();
+}
+
+void ActionsLog::Message(const char* fmt, va_list ap)
+{
+	if (ext_actions_log_async.GetBool())
+	{
+		if (IsRunning() || Start())
+		{
+			Push(fmt, ap);
+			return;
+		}
+
+		/* Don't retry opening file on every message */
+		ext_actions_log_async.SetValue("0");
+	}
+	else if (IsRunning())
+	{
+		Stop();
+	}
+
+	char buffer[2048];
+	vsnprintf(buffer, sizeof(buffer), fmt, ap);
+	g_pSM->LogMessage(myself, "%s", buffer);
+}
+
+void ActionsLog::Push(const char* fmt, va_list ap)
+{
+	size_t head = m_head.load(std::memory_order_relaxed);
+
+	if (head - m_tail.load(std::memory_order_acquire) >= CAPACITY)
+	{
+		m_dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	/* Formatted straight into the slot, work on game thread is bounded by record size */
+	Record& record = m_records[head & (CAPACITY - 1)];
+	int length = vsnprintf(record.text, sizeof(record.text), fmt, ap);
+
+	if (length < 0)
+	{
+		length = 0;
+	}
+	else if (static_cast<size_t>(length) >= sizeof(record.text))
+	{
+		length = sizeof(record.text) - 1;
+		m_truncated++;
+	}
+
+	record.time = time(NULL);
+	record.length = static_cast<uint32_t>(length);
+
+	m_head.store(head + 1, std::memory_order_release);
+}
+
+bool ActionsLog::Start()
+{
+	if (IsRunning())
+		return true;
+
+	smutils->BuildPath(Path_SM, m_path, sizeof(m_path), "logs/actions.log");
+
+	/* Opened here so failure can be reported, writer owns the file afterwards */
+	m_file = fopen(m_path, "a");
+
+	if (m_file == NULL)
+	{
+		LOGERROR("Failed to open \"%s\" for asynchronous log", m_path);
+		return false;
+	}
+
+	fseek(m_file, 0, SEEK_END);
+	m_fileSize = ftell(m_file);
+
+	if (m_records == NULL)
+		m_records.reset(new Record[CAPACITY]);
+
+	m_head.store(0, std::memory_order_relaxed);
+	m_tail.store(0, std::memory_order_relaxed);
+	m_dropped.store(0, std::memory_order_relaxed);
+	m_running.store(true, std::memory_order_release);
+
+	m_thread = std::thread(&ActionsLog::Run, this);
+	return true;
+}
+
+void ActionsLog::Stop()
+{
+	if (!IsRunning())
+		return;
+
+	m_running.store(false, std::memory_order_release);
+	m_thread.join();
+}
+
+void ActionsLog::Run()
+{
+	while (true)
+	{
+		/* Read before draining, everything pushed before Stop is written */
+		bool running = m_running.load(std::memory_order_acquire);
+
+		if (Drain() != 0)
+			continue;
+
+		if (!running)
+			break;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	if (m_file != NULL)
+	{
+		fclose(m_file);
+		m_file = NULL;
+	}
+}
+
+size_t ActionsLog::Drain()
+{
+	size_t tail = m_tail.load(std::memory_order_relaxed);
+	size_t head = m_head.load(std::memory_order_acquire);
+	uint32_t dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+	size_t count = head - tail;
+
+	for (; tail != head; tail++)
+	{
+		Write(m_records[tail & (CAPACITY - 1)]);
+		m_tail.store(tail + 1, std::memory_order_release);
+	}
+
+	/* Drops happened after queued records were pushed */
+	if (dropped != 0)
+	{
+		Record record;
+		record.time = time(NULL);
+		record.length = snprintf(record.text, sizeof(record.text), "Log queue was full, dropped %u message(s)", dropped);
+		Write(record);
+	}
+
+	if (m_file != NULL && (count != 0 || dropped != 0))
+		fflush(m_file);
+
+	return count;
+}
+
+void ActionsLog::Write(const Record& record)
+{
+	if (m_file == NULL)
+		return;
+
+	struct tm local;
+
+#ifndef __linux__
+	localtime_s(&local, &record.time);
+#else
+	localtime_r(&record.time, &local);
+#endif
+
+	char date[32];
+	strftime(date, sizeof(date), "%m/%d/%Y - %H:%M:%S", &local);
+
+	int written = fprintf(m_file, "L %s: %.*s\n", date, static_cast<int>(record.length), record.text);
+
+	if (written <= 0)
+		return;
+
+	m_fileSize += written;
+	m_written.fetch_add(written, std::memory_order_relaxed);
+
+	if (m_fileSize >= MAX_FILE_SIZE)
+		Rotate();
+}
+
+void ActionsLog::Rotate()
+{
+	fclose(m_file);
+
+	char from[MAX_PATH_LENGTH], to[MAX_PATH_LENGTH];
+
+	if (FormatPath(to, sizeof(to), MAX_FILES - 1))
+		remove(to);
+
+	/* Truncated name could be some other file, those steps are skipped */
+	for (int i = MAX_FILES - 1; i > 0; i--)
+	{
+		if (FormatPath(from, sizeof(from), i - 1) && FormatPath(to, sizeof(to), i))
+			rename(from, to);
+	}
+
+	m_file = fopen(m_path, "w");
+	m_fileSize = 0;
+}
+
+bool ActionsLog::FormatPath(char* buffer, size_t maxlength, int index) const
+{
+	int length;
+
+	if (index == 0)
+		length = snprintf(buffer, maxlength, "%s", m_path);
+	else
+		length = snprintf(buffer, maxlength, "%s.%i", m_path, index);
+
+	return length >= 0 && static_cast<size_t>(length) < maxlength;
+}
+
+/* Status bypasses the queue, it's asked for from console */
+void ActionsLog::Status() const
+{
+	if (!IsRunning())
+	{
+		g_pSM->LogMessage(myself, "Asynchronous log is off, messages go to SourceMod logs");
+		return;
+	}
+
+	size_t queued = m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+
+	g_pSM->LogMessage(myself, "Asynchronous log: %s", m_path);
+	g_pSM->LogMessage(myself, "  queued %u/%u, dropped %u, truncated %u, written %llu bytes", (unsigned)queued, (unsigned)CAPACITY,
+		m_dropped.load(std::memory_order_relaxed), m_truncated, (unsigned long long)m_written.load(std::memory_order_relaxed));
+}
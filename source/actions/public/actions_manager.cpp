@@ -1,14 +1,27 @@
+#include <algorithm>
+#include <vector>
+
 #include "extension.h"
 
 #include "actions_manager.h"
 #include "actions_propagate.h"
+#include "actions_userdata.h"
+#include "actions_names.h"
+#include "actions_recorder.h"
+#include "actions_processor.h"
+#include "actions_batch.h"
+
+ConVar ext_actions_handles("ext_actions_handles", "0", FCVAR_NONE, "Give plugins generation checked action handles instead of raw addresses");
+
+ConVar ext_actions_pending_limit("ext_actions_pending_limit", "2048", FCVAR_NONE, "Max tracked never started actions, oldest stop being valid for plugins above it (0 - no limit)");
+ConVar ext_actions_pending_lifetime("ext_actions_pending_lifetime", "0", FCVAR_NONE, "Seconds after which never started actions stop being tracked (0 - keep forever)");
 
 ActionsManager g_ActionsManager;
 ActionsManager* g_pActionsManager = &g_ActionsManager;
 
-ActionsManager::ActionsManager() : m_pRuntimeAction(NULL), m_pRuntimeResult(NULL), m_pRuntimeActor(NULL)
+ActionsManager::ActionsManager() : m_lastPendingSweep(0.0f), m_changeHooks(false), m_censusTotal(), m_ignored(), m_ignoredCount(0), m_intentions(), m_pRuntimeAction(NULL), m_pRuntimeResult(NULL), m_pRuntimeActor(NULL), m_pRuntimeArg(NULL)
 {
-	m_init = m_actions.init();
+	m_init = m_owners.init() && m_pendingActions.init() && m_watchers.init();
 
 	if (!m_init)
 	{
@@ -21,25 +34,29 @@ ActionsManager::~ActionsManager()
 	if (!m_init)
 		return;
 
-	m_actions.clear();
+	for (auto& queque : m_actions)
+		queque.reset();
+
+	m_owners.clear();
 	m_pendingActions.clear();
 }
 
 bool ActionsManager::Add(cell_t entity, Action* action)
 {
-	if (IsCaptured(action))
+	if (!IsValidEntity(entity) || IsCaptured(action))
 		return false;
 
-	auto i = m_actions.findForAdd(entity);
-
-	if (!i.found())
-		m_actions.add(i, entity, ActionsQueque());
-
-	if (IsCaptured(entity, action))
+	if (!m_actions[entity].push_back(action))
+	{
+		LOGERROR("Failed to grow actions storage of entity %i, \"%s\" is not captured", entity, action->GetName());
 		return false;
+	}
+
+	auto owner = m_owners.findForAdd(action);
+	m_owners.add(owner, action, entity);
 
 	LOGDEBUG("ActionsManager::Add -> %s", action->GetName());
-	i->value.push_back(action);
+	g_pActionsRecorder->OnActionAdded(entity, action);
 	ActionsManager::OnActionAdded(action);
 	return true;
 }
@@ -61,20 +78,25 @@ bool ActionsManager::Add(Action* action)
 
 bool ActionsManager::Remove(cell_t entity, Action* action)
 {
-	auto r = m_actions.find(entity);
-
-	if (!r.found())
+	if (!IsValidEntity(entity))
 		return false;
 
-	ActionsQueque& queque = r->value;
+	ActionsQueque& queque = m_actions[entity];
 
 	for (auto iter = queque.begin(); iter != queque.end(); iter++)
 	{
 		if (*iter == action)
 		{
 			queque.erase(iter);
+
+			auto owner = m_owners.find(action);
+			if (owner.found())
+				m_owners.remove(owner);
+
 			LOGDEBUG("ActionsManager::Remove -> %s", action->GetName());
+			g_pActionsRecorder->OnActionRemoved(entity, action);
 			ActionsManager::OnActionDestroyed(action);
+			m_handles.Release(action);
 			return true;
 		}
 	}
@@ -94,79 +116,174 @@ bool ActionsManager::Remove(CBaseEntity* pEntity, Action* action)
 
 bool ActionsManager::Remove(Action* action)
 {
-	auto iterator = m_actions.iter();
+	auto owner = m_owners.find(action);
+
+	if (!owner.found())
+		return false;
+
+	return Remove(owner->value, action);
+}
 
-	while (!iterator.empty())
+bool ActionsManager::IsCaptured(cell_t entity, Action* action) const
+{
+	auto owner = m_owners.find(action);
+	return owner.found() && owner->value == entity;
+}
+
+bool ActionsManager::IsCaptured(Action* action) const
+{
+	return m_owners.find(action).found();
+}
+
+bool ActionsManager::IsCaptured(cell_t entity) const
+{
+	return IsValidEntity(entity) && !m_actions[entity].empty();
+}
+
+size_t ActionsManager::GetEntityActions(cell_t entity, std::vector<Action*>* actions)
+{
+	if (!IsValidEntity(entity))
+		return 0;
+
+	auto& quequ = m_actions[entity];
+	size_t count = 0;
+
+	for (auto action : quequ)
 	{
-		if (Remove(iterator->key, action))
-			return true;
+		if (actions)
+			actions->push_back(action);
 
-		iterator.next();
+		count++;
 	}
 
-	return false;
+	return count;
 }
 
-bool ActionsManager::IsCaptured(cell_t entity, Action* action) const
+cell_t ActionsManager::GetActionOwner(Action* action) const
 {
-	auto lookup = m_actions.find(entity);
-	
-	if (!lookup.found())
-		return false;
+	auto owner = m_owners.find(action);
+
+	if (!owner.found())
+		return -1;
 
-	ActionsQueque& queque = lookup->value;
+	return owner->value;
+}
 
-	for (auto q = queque.begin(); q != queque.end(); q++)
+void ActionsManager::GetMemoryUsage(MemoryUsage& usage) const
+{
+	usage = {};
+	usage.table = sizeof(m_actions);
+	usage.owners = m_owners.estimateMemoryUse();
+	usage.pending = m_pendingActions.estimateMemoryUse();
+	usage.handles = m_handles.GetMemoryUsage();
+	usage.userdata = g_pActionsUserData->GetMemoryUsage();
+
+	for (const auto& queque : m_actions)
 	{
-		if (*q != action)
+		/* Emptied slots keep their heap buffer */
+		usage.spilled += queque.GetHeapUsage();
+
+		if (queque.empty())
 			continue;
 
-		return true;
+		usage.actions += queque.size();
+		usage.entities++;
 	}
-
-	return false;
 }
 
-bool ActionsManager::IsCaptured(Action* action) const
+void ActionsManager::CountCensus(Action* action, bool added)
 {
-	auto iter = m_actions.iter();
-	
-	while(!iter.empty())
+	const uint32_t id = g_pActionsNames->GetNameId(action);
+
+	if (id >= m_census.size())
+		m_census.resize(id + 1);
+
+	for (CensusCounters* counters : { &m_census[id], &m_censusTotal })
 	{
-		if (IsCaptured(iter->key, action))
-			return true;
+		if (added)
+		{
+			counters->created++;
 
-		iter.next();
+			if (++counters->live > counters->peak)
+				counters->peak = counters->live;
+		}
+		else if (counters->live != 0)
+		{
+			counters->live--;
+		}
 	}
-
-	return false;
 }
 
-bool ActionsManager::IsCaptured(cell_t entity) const
+bool ActionsManager::GetCensus(uint32_t nameId, CensusCounters& counters) const
 {
-	const auto lookup = m_actions.find(entity);
-	return lookup.found();
+	counters = {};
+	bool found = false;
+
+	if (nameId == ActionsNames::INVALID_NAME_ID)
+	{
+		counters = m_censusTotal;
+		counters.pending = m_pendingActions.elements();
+		return true;
+	}
+
+	if (nameId < m_census.size())
+	{
+		counters = m_census[nameId];
+		found = counters.created != 0;
+	}
+
+	counters.pending = 0;
+
+	/* Pending set is bounded by ext_actions_pending_limit */
+	for (auto iter = m_pendingActions.iter(); !iter.empty(); iter.next())
+	{
+		if (iter->value.nameId == nameId)
+			counters.pending++;
+	}
+
+	return found || counters.pending != 0;
 }
 
-size_t ActionsManager::GetEntityActions(cell_t entity, std::vector<Action*>* actions)
+void ActionsManager::ReportCensus() const
 {
-	auto r = m_actions.find(entity);
+	std::vector<uint32_t> pending(m_census.size() > g_pActionsNames->GetCount() ? m_census.size() : g_pActionsNames->GetCount() + 1);
 
-	if (!r.found())
-		return 0;
+	for (auto iter = m_pendingActions.iter(); !iter.empty(); iter.next())
+	{
+		const uint32_t id = iter->value.nameId;
 
-	auto& quequ = r->value;
-	size_t count = 0;
+		if (id < pending.size())
+			pending[id]++;
+	}
 
-	for (auto action : quequ)
+	std::vector<uint32_t> ids;
+
+	for (uint32_t id = 1; id < pending.size(); id++)
 	{
-		if (actions)
-			actions->push_back(action);
+		if ((id < m_census.size() && m_census[id].created != 0) || pending[id] != 0)
+			ids.push_back(id);
+	}
 
-		count++;
+	/* Most alive first, that's where memory goes */
+	std::sort(ids.begin(), ids.end(), [this](uint32_t a, uint32_t b)
+	{
+		uint32_t liveA = a < m_census.size() ? m_census[a].live : 0;
+		uint32_t liveB = b < m_census.size() ? m_census[b].live : 0;
+		return liveA > liveB;
+	});
+
+	CensusCounters total;
+	GetCensus(ActionsNames::INVALID_NAME_ID, total);
+
+	LOG("%-40s %8s %8s %10s %8s", "Action", "Live", "Peak", "Created", "Pending");
+
+	for (uint32_t id : ids)
+	{
+		CensusCounters counters = id < m_census.size() ? m_census[id] : CensusCounters();
+		LOG("%-40s %8u %8u %10llu %8u", g_pActionsNames->GetName(id), counters.live, counters.peak, (unsigned long long)counters.created, pending[id]);
 	}
 
-	return count;
+	LOG("%-40s %8u %8u %10llu %8u", "Total", total.live, total.peak, (unsigned long long)total.created, total.pending);
 }
 
 bool ActionsManager::IsValidAction(Action* action) const
@@ -181,6 +298,67 @@ bool ActionsManager::IsValidAction(Action* action) const
 #endif
 }
 
+void ActionsManager::SetEntityIgnored(CBaseEntity* pEntity, bool ignored)
+{
+	if (!ignored && m_ignoredCount == 0)
+		return;
+
+	const cell_t entity = gamehelpers->EntityToBCompatRef(pEntity);
+
+	if (!IsValidEntity(entity))
+		return;
+
+	cell_t& ref = m_ignored[entity];
+
+	if (ignored)
+	{
+		if (ref == 0)
+			m_ignoredCount++;
+
+		ref = gamehelpers->EntityToReference(pEntity);
+	}
+	else if (ref != 0)
+	{
+		ref = 0;
+		m_ignoredCount--;
+	}
+}
+
+bool ActionsManager::IsEntityIgnored(CBaseEntity* pEntity) const
+{
+	if (m_ignoredCount == 0 || pEntity == NULL)
+		return false;
+
+	const cell_t entity = gamehelpers->EntityToBCompatRef(pEntity);
+
+	if (!IsValidEntity(entity) || m_ignored[entity] == 0)
+		return false;
+
+	/* Index may be taken by another entity already */
+	return m_ignored[entity] == gamehelpers->EntityToReference(pEntity);
+}
+
+void ActionsManager::SetEntityIntention(CBaseEntity* pEntity, uint32_t nameId)
+{
+	const cell_t entity = gamehelpers->EntityToBCompatRef(pEntity);
+
+	if (IsValidEntity(entity))
+		m_intentions[entity] = nameId;
+}
+
+uint32_t ActionsManager::GetEntityIntention(CBaseEntity* pEntity) const
+{
+	if (pEntity == NULL)
+		return 0;
+
+	const cell_t entity = gamehelpers->EntityToBCompatRef(pEntity);
+
+	if (!IsValidEntity(entity))
+		return 0;
+
+	return m_intentions[entity];
+}
+
 bool ActionsManager::IsValidResult(const void* const result) const
 {
 #ifdef NO_RUNTIME_VALIDATION
@@ -193,45 +371,433 @@ bool ActionsManager::IsValidResult(const void* const result) const
 #endif
 }
 
+cell_t ActionsManager::ToCell(Action* action)
+{
+	if (action == NULL)
+		return 0;
+
+	cell_t handle = m_handles.Find(action);
+
+	if (handle != 0)
+		return handle;
+
+	/* Untracked actions have nothing to release their handle, so they stay raw */
+	if (!ext_actions_handles.GetBool() || (!IsCaptured(action) && !IsPending(action)))
+		return (cell_t)(intptr_t)action;
+
+	handle = m_handles.Acquire(action);
+
+	if (handle == 0)
+		return (cell_t)(intptr_t)action;
+
+	return handle;
+}
+
+Action<void>* ActionsManager::FromCell(cell_t cell) const noexcept
+{
+	if (ActionHandles::IsHandle(cell))
+		return m_handles.Resolve(cell);
+
+	return (Action*)cell;
+}
+
+Action<void>* ActionsManager::ResolveAction(cell_t cell) const
+{
+	if (ActionHandles::IsHandle(cell))
+		return m_handles.Resolve(cell);
+
+	Action* action = (Action*)cell;
+
+	if (!IsValidAction(action))
+		return NULL;
+
+	return action;
+}
+
 bool ActionsManager::AddPending(Action* action)
 {
-	if (IsPending(action))
+	auto i = m_pendingActions.findForAdd(action);
+
+	if (i.found())
 		return false;
 
-	m_pendingActions.push_back(action);
+	m_pendingActions.add(i, action, PendingAction{ gpGlobals->realtime, g_pActionsNames->GetNameId(action) });
+	EnforcePendingLimits(action);
 	return true;
 }
 
 bool ActionsManager::RemovePending(Action* action)
 {
-	return IsPending(action, true);
+	auto r = m_pendingActions.find(action);
+
+	if (!r.found())
+		return false;
+
+	m_pendingActions.remove(r);
+
+	/* Action keeps its handle and data when it becomes captured */
+	if (!IsCaptured(action))
+	{
+		m_handles.Release(action);
+		g_pActionsUserData->OnActionDestroyed(action);
+	}
+
+	return true;
+}
+
+void ActionsManager::OnActionFreed(Action* action)
+{
+	if (Remove(action))
+		return;
+
+	/* Never started action deleted by game (superseded pending result) or replaced by a listener */
+	if (RemovePending(action))
+		ActionsPropagate::OnActionDestroyed(action);
+}
+
+bool ActionsManager::IsPending(Action* action) const
+{
+	return m_pendingActions.find(action).found();
 }
 
-bool ActionsManager::IsPending(Action* action, bool erase) const
-{	
-	for(iterator iter = m_pendingActions.begin(); iter != m_pendingActions.end(); iter++)
+void ActionsManager::EnforcePendingLimits(Action* added)
+{
+	const size_t limit = (size_t)std::max(ext_actions_pending_limit.GetInt(), 0);
+	const float lifetime = ext_actions_pending_lifetime.GetFloat();
+	const float now = gpGlobals->realtime;
+
+	const bool overLimit = limit != 0 && m_pendingActions.elements() > limit;
+	const bool sweep = lifetime > 0.0f && now - m_lastPendingSweep >= 1.0f;
+
+	if (!overLimit && !sweep)
+		return;
+
+	m_lastPendingSweep = now;
+
+	std::vector<std::pair<float, Action*>> pending;
+
+	for (auto iter = m_pendingActions.iter(); !iter.empty(); iter.next())
 	{
-		if (*iter == action)
-		{
-			if (erase)
-				m_pendingActions.erase(iter);
+		if (iter->key != added && iter->key != GetRuntimeAction())
+			pending.push_back({ iter->value.created, iter->key });
+	}
 
-			return true;
+	std::sort(pending.begin(), pending.end());
+
+	size_t drop = 0;
+
+	/* Untrack a bit more than needed so we don't sort on every next AddPending */
+	if (overLimit)
+		drop = m_pendingActions.elements() - limit + limit / 10;
+
+	if (lifetime > 0.0f)
+	{
+		size_t expired = 0;
+
+		while (expired < pending.size() && now - pending[expired].first > lifetime)
+			expired++;
+
+		drop = std::max(drop, expired);
+	}
+
+	drop = std::min(drop, pending.size());
+
+	if (drop == 0)
+		return;
+
+	/* Plugins or a stored event result may still point to them, so they are only forgotten, never deleted */
+	LOGERROR("Untracking %u never started actions (%u pending), oldest \"%s\" was created %.1f seconds ago. Some plugin leaks ActionsManager.Create results",
+		(unsigned)drop, (unsigned)m_pendingActions.elements(), PendingName(pending[0].second), now - pending[0].first);
+
+	for (size_t i = 0; i < drop; i++)
+		UntrackPending(pending[i].second);
+}
+
+const char* ActionsManager::PendingName(Action* action) const
+{
+	auto r = m_pendingActions.find(action);
+	const char* name = r.found() ? g_pActionsNames->GetName(r->value.nameId) : NULL;
+	return name != NULL ? name : "<unknown>";
+}
+
+void ActionsManager::UntrackPending(Action* action)
+{
+	RemovePending(action);
+	ActionsPropagate::OnActionDestroyed(action);
+}
+
+void ActionsManager::ReportPending() const
+{
+	const float now = gpGlobals->realtime;
+	std::vector<std::pair<float, Action*>> pending;
+
+	for (auto iter = m_pendingActions.iter(); !iter.empty(); iter.next())
+		pending.push_back({ iter->value.created, iter->key });
+
+	std::sort(pending.begin(), pending.end());
+
+	LOG("%u pending actions (limit: %i, lifetime: %.1f):", (unsigned)pending.size(), ext_actions_pending_limit.GetInt(), ext_actions_pending_lifetime.GetFloat());
+
+	for (size_t i = 0; i < pending.size(); i++)
+	{
+		LOG("%u. %s ( %X ) created %.1f seconds ago", (unsigned)(i + 1), PendingName(pending[i].second), (unsigned)(uintptr_t)pending[i].second, now - pending[i].first);
+	}
+}
+
+bool ActionsManager::AddWatcher(const char* name, IPluginFunction* callback, bool destroyed)
+{
+	NameWatchers* watchers = NULL;
+
+	const uint32_t id = g_pActionsNames->Intern(name);
+	auto i = m_watchers.findForAdd(id);
+
+	if (i.found())
+	{
+		watchers = i->value;
+	}
+	else
+	{
+		watchers = new NameWatchers();
+		watchers->name = name;
+		watchers->nameId = id;
+
+		m_watchers.add(i, id, watchers);
+		m_watchersList.push_back(watchers);
+	}
+
+	auto& callbacks = destroyed ? watchers->destroyed : watchers->created;
+
+	if (std::find(callbacks.begin(), callbacks.end(), callback) != callbacks.end())
+		return false;
+
+	callbacks.push_back(callback);
+	return true;
+}
+
+bool ActionsManager::RemoveWatcher(const char* name, IPluginFunction* callback, bool destroyed)
+{
+	auto r = m_watchers.find(g_pActionsNames->Lookup(name));
+
+	if (!r.found())
+		return false;
+
+	NameWatchers* watchers = r->value;
+
+	auto& callbacks = destroyed ? watchers->destroyed : watchers->created;
+	auto iter = std::find(callbacks.begin(), callbacks.end(), callback);
+
+	if (iter == callbacks.end())
+		return false;
+
+	callbacks.erase(iter);
+
+	if (watchers->created.empty() && watchers->destroyed.empty())
+		DestroyWatchers(watchers);
+
+	return true;
+}
+
+void ActionsManager::RemoveWatchers(IPluginContext* context)
+{
+	auto owned = [context](IPluginFunction* callback) -> bool
+	{
+		return callback->GetParentRuntime()->GetDefaultContext() == context;
+	};
+
+	std::vector<NameWatchers*> list = m_watchersList;
+
+	for (NameWatchers* watchers : list)
+	{
+		watchers->created.erase(std::remove_if(watchers->created.begin(), watchers->created.end(), owned), watchers->created.end());
+		watchers->destroyed.erase(std::remove_if(watchers->destroyed.begin(), watchers->destroyed.end(), owned), watchers->destroyed.end());
+
+		if (watchers->created.empty() && watchers->destroyed.empty())
+			DestroyWatchers(watchers);
+	}
+
+	m_changeWatchers.erase(std::remove_if(m_changeWatchers.begin(), m_changeWatchers.end(), [&owned](const ChangeWatcher& watcher)
+	{
+		return owned(watcher.callback);
+	}), m_changeWatchers.end());
+
+	UpdateChangeHooks();
+}
+
+void ActionsManager::DestroyWatchers(NameWatchers* watchers)
+{
+	auto r = m_watchers.find(watchers->nameId);
+	m_watchers.remove(r);
+	m_watchersList.erase(std::find(m_watchersList.begin(), m_watchersList.end(), watchers));
+	delete watchers;
+}
+
+void ActionsManager::NotifyWatchers(Action* action, cell_t actor, bool destroyed)
+{
+	if (m_watchersList.empty())
+		return;
+
+	auto r = m_watchers.find(g_pActionsNames->GetNameId(action));
+
+	if (!r.found())
+		return;
+
+	NameWatchers* watchers = r->value;
+
+	auto& callbacks = destroyed ? watchers->destroyed : watchers->created;
+
+	if (callbacks.empty())
+		return;
+
+	/* Callbacks may unwatch while we are executing them */
+	SmallVector<IPluginFunction*, 8> snapshot;
+	snapshot.assign(callbacks.data(), callbacks.size());
+
+	for (IPluginFunction* callback : snapshot)
+	{
+		callback->PushCell(ToCell(action));
+		callback->PushCell(actor);
+		callback->Execute(NULL);
+	}
+}
+
+bool ActionsManager::AddChangeWatcher(IPluginFunction* callback, cell_t entity, uint32_t nameId)
+{
+	for (const ChangeWatcher& watcher : m_changeWatchers)
+	{
+		if (watcher.callback == callback)
+			return false;
+	}
+
+	m_changeWatchers.push_back({ callback, entity, nameId });
+	UpdateChangeHooks();
+	return true;
+}
+
+bool ActionsManager::RemoveChangeWatcher(IPluginFunction* callback)
+{
+	auto iter = std::find_if(m_changeWatchers.begin(), m_changeWatchers.end(), [callback](const ChangeWatcher& watcher)
+	{
+		return watcher.callback == callback;
+	});
+
+	if (iter == m_changeWatchers.end())
+		return false;
+
+	m_changeWatchers.erase(iter);
+	UpdateChangeHooks();
+	return true;
+}
+
+static IForward* GetChangedForward()
+{
+	static IForward* forward = forwards->CreateForward("OnActionChanged", ET_Ignore, 5, NULL, Param_Cell, Param_Cell, Param_Cell, Param_Cell, Param_String);
+	return forward;
+}
+
+void ActionsManager::UpdateChangeHooks()
+{
+	bool used = !m_changeWatchers.empty() || GetChangedForward()->GetFunctionCount() != 0;
+
+	if (used == m_changeHooks)
+		return;
+
+	/* Game's own transitions are only known after handler returned */
+	if (used)
+		ActionProcessor::RequestEventHandlers(true);
+	else
+		ActionProcessor::ReleaseEventHandlers(true);
+
+	m_changeHooks = used;
+}
+
+void ActionsManager::OnActionChanged(Action* action, ActionResultType type, Action* target, const char* reason, size_t vtableidx, bool post)
+{
+	IForward* forward = GetChangedForward();
+
+	if (post)
+	{
+		/* Nested dispatches finish first, so ours is the last one of this action and handler */
+		for (size_t i = m_reportedChanges.size(); i-- > 0;)
+		{
+			if (m_reportedChanges[i].action == action && m_reportedChanges[i].vtableidx == vtableidx)
+			{
+				m_reportedChanges.erase(m_reportedChanges.begin() + i);
+				return;
+			}
 		}
 	}
 
-	return false;
+	if (m_changeWatchers.empty() && forward->GetFunctionCount() == 0)
+		return;
+
+	/* Post processor of this dispatch sees the same transition */
+	if (!post && ActionProcessor::IsHandlerHooked(action, vtableidx, true))
+		m_reportedChanges.push_back({ action, vtableidx });
+
+	/* Finished action gives control back to one it was suspended for */
+	if (type == DONE)
+		target = action->m_buriedUnderMe;
+
+	cell_t actor = gamehelpers->EntityToBCompatRef(static_cast<CBaseEntity*>(action->GetActor()));
+	cell_t from = ToCell(action);
+	cell_t to = ToCell(target);
+
+	if (reason == NULL)
+		reason = "";
+
+	if (forward->GetFunctionCount() != 0)
+	{
+		forward->PushCell(actor);
+		forward->PushCell(from);
+		forward->PushCell(to);
+		forward->PushCell(type);
+		forward->PushString(reason);
+		forward->Execute();
+	}
+
+	if (m_changeWatchers.empty())
+		return;
+
+	const uint32_t fromId = g_pActionsNames->GetNameId(action);
+	const uint32_t toId = target != NULL ? g_pActionsNames->GetNameId(target) : ActionsNames::INVALID_NAME_ID;
+
+	/* Callbacks may unwatch while we are executing them */
+	SmallVector<ChangeWatcher, 8> snapshot;
+	snapshot.assign(m_changeWatchers.data(), m_changeWatchers.size());
+
+	for (const ChangeWatcher& watcher : snapshot)
+	{
+		if (watcher.entity != -1 && watcher.entity != actor)
+			continue;
+
+		if (watcher.nameId != ActionsNames::INVALID_NAME_ID && watcher.nameId != fromId && watcher.nameId != toId)
+			continue;
+
+		watcher.callback->PushCell(actor);
+		watcher.callback->PushCell(from);
+		watcher.callback->PushCell(to);
+		watcher.callback->PushCell(type);
+		watcher.callback->PushString(reason);
+		watcher.callback->Execute(NULL);
+	}
 }
 
 void ActionsManager::OnActionAdded(Action* action)
 {
 	static IForward* forward = forwards->CreateForward("OnActionCreated", ET_Ignore, 3, NULL, Param_Cell, Param_Cell, Param_String); 
 
-	forward->PushCell((cell_t)action);
-	forward->PushCell(gamehelpers->EntityToBCompatRef(g_pActionsManager->m_pRuntimeActor));
-	forward->PushString(action->GetName());
-	forward->Execute();
-	
+	cell_t actor = gamehelpers->EntityToBCompatRef(g_pActionsManager->m_pRuntimeActor);
+
+	if (forward->GetFunctionCount() != 0)
+	{
+		forward->PushCell(g_pActionsManager->ToCell(action));
+		forward->PushCell(actor);
+		forward->PushString(action->GetName());
+		forward->Execute();
+	}
+
+	g_pActionsManager->CountCensus(action, true);
+	g_pActionsManager->NotifyWatchers(action, actor, false);
 	g_pActionsManager->RemovePending(action);
 	ActionsPropagate::OnActionAdded(action);
 }
@@ -240,10 +806,27 @@ void ActionsManager::OnActionDestroyed(Action* action)
 {
 	static IForward* forward = forwards->CreateForward("OnActionDestroyed", ET_Ignore, 3, NULL, Param_Cell, Param_Cell, Param_String);
 
-	forward->PushCell((cell_t)action);
-	forward->PushCell(gamehelpers->EntityToBCompatRef(static_cast<CBaseEntity*>(action->GetActor())));
-	forward->PushString(action->GetName());
-	forward->Execute();
+	cell_t actor = gamehelpers->EntityToBCompatRef(static_cast<CBaseEntity*>(action->GetActor()));
+
+	if (forward->GetFunctionCount() != 0)
+	{
+		forward->PushCell(g_pActionsManager->ToCell(action));
+		forward->PushCell(actor);
+		forward->PushString(action->GetName());
+		forward->Execute();
+	}
+
+	g_pActionsManager->CountCensus(action, false);
+	g_pActionsManager->NotifyWatchers(action, actor, true);
+	g_pActionsUserData->OnActionDestroyed(action);
+	g_pActionsBatch->OnActionDestroyed(action);
+
+	/* Dispatch can end with action destroyed before its post processor runs */
+	std::vector<ReportedChange>& reported = g_pActionsManager->m_reportedChanges;
+	reported.erase(std::remove_if(reported.begin(), reported.end(), [action](const ReportedChange& change)
+	{
+		return change.action == action;
+	}), reported.end());
 
 	ActionsPropagate::OnActionDestroyed(action);
 }
@@ -269,6 +852,16 @@ void* const ActionsManager::GetRuntimeResult() const noexcept
 	return m_pRuntimeResult;
 }
 
+void ActionsManager::SetRuntimeArg(const void* arg) noexcept
+{
+	m_pRuntimeArg = arg;
+}
+
+const void* ActionsManager::GetRuntimeArg() const noexcept
+{
+	return m_pRuntimeArg;
+}
+
 void ActionsManager::SetRuntimeActor(CBaseEntity* actor) noexcept
 {
 	m_pRuntimeActor = actor;
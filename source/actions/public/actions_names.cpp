@@ -0,0 +1,74 @@
+#include "extension.h"
+#include "actions_names.h"
+
+ActionsNames g_ActionsNames;
+ActionsNames* g_pActionsNames = &g_ActionsNames;
+
+ActionsNames::ActionsNames()
+{
+	/* Reserve INVALID_NAME_ID */
+	m_names.emplace_back();
+
+	if (!m_vtables.init())
+	{
+		LOGERROR("Failed to init ActionsNames");
+	}
+}
+
+uint32_t ActionsNames::Intern(const char* name)
+{
+	if (name == NULL)
+		return INVALID_NAME_ID;
+
+	auto i = m_ids.findForAdd(name);
+
+	if (i.found())
+		return i->value;
+
+	uint32_t id = static_cast<uint32_t>(m_names.size());
+
+	m_names.emplace_back(name);
+	m_ids.add(i, name, id);
+	return id;
+}
+
+uint32_t ActionsNames::Lookup(const char* name) const
+{
+	uint32_t id;
+
+	if (name == NULL || !m_ids.retrieve(name, &id))
+		return INVALID_NAME_ID;
+
+	return id;
+}
+
+uint32_t ActionsNames::GetNameId(Action<void>* action)
+{
+	void* vtable = *reinterpret_cast<void**>(action);
+	auto i = m_vtables.findForAdd(vtable);
+
+	if (i.found())
+	{
+		if (i->value != DYNAMIC_NAME_ID)
+			return i->value;
+
+		return Intern(action->GetName());
+	}
+
+	uint32_t id = Intern(action->GetName());
+	m_vtables.add(i, vtable, id);
+	return id;
+}
+
+void ActionsNames::AddDynamicVTable(void* vtable)
+{
+	auto i = m_vtables.findForAdd(vtable);
+
+	if (i.found())
+	{
+		i->value = DYNAMIC_NAME_ID;
+		return;
+	}
+
+	m_vtables.add(i, vtable, DYNAMIC_NAME_ID);
+}
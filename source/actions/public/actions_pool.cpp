@@ -0,0 +1,125 @@
+#include <new>
+
+#include "extension.h"
+#include "actions_pool.h"
+
+ActionsPool g_ActionsPool;
+ActionsPool* g_pActionsPool = &g_ActionsPool;
+
+ActionsPool::ActionsPool() : m_free(), m_stats(), m_oversized(0)
+{
+}
+
+ActionsPool::~ActionsPool()
+{
+	Flush();
+}
+
+void* ActionsPool::Alloc(size_t size, bool detached)
+{
+	if (size == 0 || size > MAX_BLOCK_SIZE)
+	{
+		m_oversized++;
+		return ::operator new(size);
+	}
+
+	const size_t sizeClass = GetSizeClass(size);
+	SizeClassStats& stats = m_stats[sizeClass];
+	void* block = NULL;
+
+	stats.allocs++;
+
+	if (m_free[sizeClass] != NULL)
+	{
+		FreeBlock* free = m_free[sizeClass];
+		m_free[sizeClass] = free->next;
+
+		stats.cached--;
+		stats.recycled++;
+		block = free;
+	}
+	else
+	{
+		/* Always allocate whole class so block can be reused by any size in it */
+		block = ::operator new((sizeClass + 1) * GRANULARITY);
+	}
+
+	if (detached)
+	{
+		stats.detached++;
+		return block;
+	}
+
+	if (++stats.live > stats.peak)
+		stats.peak = stats.live;
+
+	return block;
+}
+
+void ActionsPool::Free(void* block, size_t size)
+{
+	if (block == NULL)
+		return;
+
+	if (size == 0 || size > MAX_BLOCK_SIZE)
+	{
+		::operator delete(block);
+		return;
+	}
+
+	const size_t sizeClass = GetSizeClass(size);
+	SizeClassStats& stats = m_stats[sizeClass];
+
+	if (stats.live > 0)
+		stats.live--;
+
+	if (stats.cached >= MAX_CACHED)
+	{
+		::operator delete(block);
+		return;
+	}
+
+	FreeBlock* free = static_cast<FreeBlock*>(block);
+	free->next = m_free[sizeClass];
+	m_free[sizeClass] = free;
+	stats.cached++;
+}
+
+void ActionsPool::Flush()
+{
+	for (size_t i = 0; i < CLASSES; i++)
+	{
+		while (m_free[i] != NULL)
+		{
+			FreeBlock* next = m_free[i]->next;
+			::operator delete(m_free[i]);
+			m_free[i] = next;
+		}
+
+		m_stats[i].cached = 0;
+	}
+}
+
+void ActionsPool::Report() const
+{
+	uint64_t allocs = 0, recycled = 0;
+	size_t cachedBytes = 0;
+
+	LOG("%-10s %-8s %-8s %-8s %-10s %-10s %-10s", "Block", "Live", "Peak", "Cached", "Allocs", "Recycled", "Detached");
+
+	for (size_t i = 0; i < CLASSES; i++)
+	{
+		const SizeClassStats& stats = m_stats[i];
+
+		if (stats.allocs == 0)
+			continue;
+
+		LOG("%-10i %-8u %-8u %-8u %-10llu %-10llu %-10llu", (i + 1) * GRANULARITY, stats.live, stats.peak, stats.cached, stats.allocs, stats.recycled, stats.detached);
+
+		allocs += stats.allocs;
+		recycled += stats.recycled;
+		cachedBytes += stats.cached * (i + 1) * GRANULARITY;
+	}
+
+	LOG("Total: %llu allocations, %llu recycled, %i bytes cached, %llu oversized (> %i bytes, not pooled)", allocs, recycled, cachedBytes, m_oversized, MAX_BLOCK_SIZE);
+}
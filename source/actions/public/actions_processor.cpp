@@ -54,72 +54,290 @@ SH_DECL_MANUALHOOK1(OnCommandResume, 0, 0, 0, EventDesiredResult<void>, CBaseEnt
 SH_DECL_MANUALHOOK2(OnCommandString, 0, 0, 0, EventDesiredResult<void>, CBaseEntity*, const char*);
 SH_DECL_MANUALHOOK1(IsAbleToBlockMovementOf, 0, 0, 0, bool, const INextBot*);
 
+#define DEFINE_HANDLER_HOOK(hookname, varname, required) \
+	{ #hookname, required, std::is_same<decltype(ActionProcessor::varname)::result_type, EventDesiredResult<void>>::value, 0, \
+	[](void* vtable, bool post) -> int \
+	{ \
+		if (post) \
+			return SH_ADD_MANUALDVPHOOK(hookname, vtable, SH_STATIC(decltype(ActionProcessor::varname)::ProcessPost), true); \
+		return SH_ADD_MANUALDVPHOOK(hookname, vtable, SH_STATIC(decltype(ActionProcessor::varname)::Process), false); \
+	}, \
+	[](size_t vtableidx, const char* name) \
+	{ \
+		decltype(ActionProcessor::varname)::vtableindex = vtableidx; \
+		decltype(ActionProcessor::varname)::name = name; \
+	} }
+
+ConVar ext_actions_lazy_hooks("ext_actions_lazy_hooks", "0", FCVAR_NONE, "Hook action handlers only while plugins listen to them (applies to newly seen action classes)");
+
+struct HandlerHook
+{
+	const char* name;
+	/* Hooked on every vtable, actions tracking relies on them */
+	bool required;
+	/* Returns EventDesiredResult */
+	bool event;
+	size_t vtableidx;
+	int (*hook)(void* vtable, bool post);
+	void (*configure)(size_t vtableidx, const char* name);
+};
+
+static HandlerHook s_handlerHooks[] =
+{
+	DEFINE_HANDLER_HOOK(OnDestroyed, dctor, true),
+	DEFINE_HANDLER_HOOK(OnStart, start, true),
+	DEFINE_HANDLER_HOOK(OnUpdate, update, true),
+	DEFINE_HANDLER_HOOK(OnEnd, end, true),
+	DEFINE_HANDLER_HOOK(OnSuspend, suspend, true),
+	DEFINE_HANDLER_HOOK(OnResume, resume, true),
+	DEFINE_HANDLER_HOOK(OnInitialContainedAction, initialAction, true),
+	DEFINE_HANDLER_HOOK(OnLeaveGround, leaveGround, false),
+	DEFINE_HANDLER_HOOK(OnLandOnGround, landGround, false),
+	DEFINE_HANDLER_HOOK(OnContact, contact, false),
+	DEFINE_HANDLER_HOOK(OnMoveToSuccess, movetoSuccess, false),
+	DEFINE_HANDLER_HOOK(OnMoveToFailure, movetoFailure, false),
+	DEFINE_HANDLER_HOOK(OnStuck, stuck, false),
+	DEFINE_HANDLER_HOOK(OnUnStuck, unstuck, false),
+	DEFINE_HANDLER_HOOK(OnPostureChanged, postureChanged, false),
+	DEFINE_HANDLER_HOOK(OnAnimationActivityComplete, animationActivityComplete, false),
+	DEFINE_HANDLER_HOOK(OnAnimationActivityInterrupted, animationActivityInterrupted, false),
+	DEFINE_HANDLER_HOOK(OnAnimationEvent, animationEvent, false),
+	DEFINE_HANDLER_HOOK(OnIgnite, ignite, false),
+	DEFINE_HANDLER_HOOK(OnInjured, injured, false),
+	DEFINE_HANDLER_HOOK(OnKilled, killed, false),
+	DEFINE_HANDLER_HOOK(OnOtherKilled, otherKilled, false),
+	DEFINE_HANDLER_HOOK(OnSight, sight, false),
+	DEFINE_HANDLER_HOOK(OnLostSight, lostSight, false),
+	DEFINE_HANDLER_HOOK(OnThreatChanged, threatChanged, false),
+	DEFINE_HANDLER_HOOK(OnSound, sound, false),
+	DEFINE_HANDLER_HOOK(OnSpokeConcept, spokeConcept, false),
+	DEFINE_HANDLER_HOOK(OnNavAreaChanged, navareaChanged, false),
+	DEFINE_HANDLER_HOOK(OnModelChanged, modelChanged, false),
+	DEFINE_HANDLER_HOOK(OnPickUp, pickup, false),
+	DEFINE_HANDLER_HOOK(OnDrop, drop, false),
+	DEFINE_HANDLER_HOOK(OnShoved, shoved, false),
+	DEFINE_HANDLER_HOOK(OnBlinded, blinded, false),
+	DEFINE_HANDLER_HOOK(OnCommandAttack, commandAttack, false),
+	DEFINE_HANDLER_HOOK(OnCommandApproachVector, commandApproachVector, false),
+	DEFINE_HANDLER_HOOK(OnCommandApproachEntity, commandApproachEntity, false),
+	DEFINE_HANDLER_HOOK(OnCommandRetreat, commandRetreat, false),
+	DEFINE_HANDLER_HOOK(OnCommandPause, commandPause, false),
+	DEFINE_HANDLER_HOOK(OnCommandResume, commandResume, false),
+	DEFINE_HANDLER_HOOK(IsAbleToBlockMovementOf, abletoBlock, false),
+
+	#if SOURCE_ENGINE == SE_LEFT4DEAD2
+		DEFINE_HANDLER_HOOK(OnCommandAssault, commandAssault, false),
+		DEFINE_HANDLER_HOOK(OnEnteredSpit, enteredSpit, false),
+		DEFINE_HANDLER_HOOK(OnHitByVomitJar, hitVomitjar, false),
+		DEFINE_HANDLER_HOOK(OnCommandString, commandString, false),
+	#endif
+};
+
+static constexpr size_t HANDLERS_COUNT = sizeof(s_handlerHooks) / sizeof(HandlerHook);
+static constexpr size_t NO_HANDLER = (size_t)-1;
+
+/* vtable index -> s_handlerHooks slot */
+static size_t s_handlerSlots[ActionsPropagate::SIZE];
+
+/* Requests for handler on every vtable (not bound to single action) */
+static size_t s_handlerRefs[HANDLERS_COUNT][2];
+
+struct ActionProcessor::VTableHooks
+{
+	void* vtable;
+	bool lazy;
+	int ids[HANDLERS_COUNT][2];
+	size_t refs[HANDLERS_COUNT][2];
+};
+
 ActionProcessor::ActionProcessor(CBaseEntity* entity, Action<void>* action) : m_action(action)
 {
+	/* Neither captured nor hooked, so actions these bots transition to are never seen either */
+	if (g_pActionsManager->IsEntityIgnored(entity))
+		return;
+
 	g_pActionsManager->SetRuntimeActor(entity);
 	g_pActionsManager->Add(entity, action);
 
-	for (auto name : m_hookedNames)
+	FindOrHookVTable(*reinterpret_cast<void**>(action));
+}
+
+ActionProcessor::ActionProcessor(Action<void>* action) : ActionProcessor(static_cast<CBaseEntity*>(action->GetActor()), action)
+{
+}
+
+ActionProcessor::HookedVTables& ActionProcessor::GetHookedVTables()
+{
+	static HookedVTables vtables;
+	static bool init = vtables.init();
+	return vtables;
+}
+
+ActionProcessor::VTableHooks* ActionProcessor::FindOrHookVTable(void* vtable)
+{
+	HookedVTables& hooked = GetHookedVTables();
+	auto i = hooked.findForAdd(vtable);
+
+	if (i.found())
+		return i->value;
+
+	VTableHooks* hooks = new VTableHooks();
+	hooks->vtable = vtable;
+	hooks->lazy = ext_actions_lazy_hooks.GetBool();
+	hooked.add(i, vtable, hooks);
+
+	for (size_t slot = 0; slot < HANDLERS_COUNT; slot++)
 	{
-		if (strcmp(name.c_str(), action->GetName()) == 0)
-			return;
+		if (hooks->lazy && !s_handlerHooks[slot].required)
+		{
+			for (int post = 0; post < 2; post++)
+			{
+				if (s_handlerRefs[slot][post] != 0)
+					HookHandler(hooks, slot, post);
+			}
+
+			continue;
+		}
+
+		HookHandler(hooks, slot, false);
+		HookHandler(hooks, slot, true);
 	}
 
-	std::map<std::string, size_t>& offsets = GetOffsetsInfo();
-	m_hookedNames.push_back(action->GetName());
-
-	START_PROCESSOR(OnDestroyed, dctor);
-	START_PROCESSOR(OnStart, start);
-	START_PROCESSOR(OnUpdate, update);
-	START_PROCESSOR(OnEnd, end);
-	START_PROCESSOR(OnSuspend, suspend);
-	START_PROCESSOR(OnResume, resume);
-	START_PROCESSOR(OnInitialContainedAction, initialAction);
-	START_PROCESSOR(OnLeaveGround, leaveGround);
-	START_PROCESSOR(OnLandOnGround, landGround);
-	START_PROCESSOR(OnContact, contact);
-	START_PROCESSOR(OnMoveToSuccess, movetoSuccess);
-	START_PROCESSOR(OnMoveToFailure, movetoFailure);
-	START_PROCESSOR(OnStuck, stuck);
-	START_PROCESSOR(OnUnStuck, unstuck);
-	START_PROCESSOR(OnPostureChanged, postureChanged);
-	START_PROCESSOR(OnAnimationActivityComplete, animationActivityComplete);
-	START_PROCESSOR(OnAnimationActivityInterrupted, animationActivityInterrupted);
-	START_PROCESSOR(OnAnimationEvent, animationEvent);
-	START_PROCESSOR(OnIgnite, ignite);
-	START_PROCESSOR(OnInjured, injured);
-	START_PROCESSOR(OnKilled, killed);
-	START_PROCESSOR(OnOtherKilled, otherKilled);
-	START_PROCESSOR(OnSight, sight);
-	START_PROCESSOR(OnLostSight, lostSight);
-	START_PROCESSOR(OnThreatChanged, threatChanged);
-	START_PROCESSOR(OnSound, sound);
-	START_PROCESSOR(OnSpokeConcept, spokeConcept);
-	START_PROCESSOR(OnNavAreaChanged, navareaChanged);
-	START_PROCESSOR(OnModelChanged, modelChanged);
-	START_PROCESSOR(OnPickUp, pickup);
-	START_PROCESSOR(OnDrop, drop);
-	START_PROCESSOR(OnShoved, shoved);
-	START_PROCESSOR(OnBlinded, blinded);
-	START_PROCESSOR(OnCommandAttack, commandAttack);
-	START_PROCESSOR(OnCommandApproachVector, commandApproachVector);
-	START_PROCESSOR(OnCommandApproachEntity, commandApproachEntity);
-	START_PROCESSOR(OnCommandRetreat, commandRetreat);
-	START_PROCESSOR(OnCommandPause, commandPause);
-	START_PROCESSOR(OnCommandResume, commandResume);
-	START_PROCESSOR(IsAbleToBlockMovementOf, abletoBlock);
+	return hooks;
+}
 
-	#if SOURCE_ENGINE == SE_LEFT4DEAD2
-		START_PROCESSOR(OnCommandAssault, commandAssault);
-		START_PROCESSOR(OnEnteredSpit, enteredSpit);
-		START_PROCESSOR(OnHitByVomitJar, hitVomitjar);
-		START_PROCESSOR(OnCommandString, commandString);
-	#endif
+void ActionProcessor::HookHandler(VTableHooks* hooks, size_t slot, bool post)
+{
+	int& id = hooks->ids[slot][post];
 
+	if (id == 0)
+		id = s_handlerHooks[slot].hook(hooks->vtable, post);
 }
 
-ActionProcessor::ActionProcessor(Action<void>* action) : ActionProcessor(static_cast<CBaseEntity*>(action->GetActor()), action)
+void ActionProcessor::UnhookHandler(VTableHooks* hooks, size_t slot, bool post)
+{
+	int& id = hooks->ids[slot][post];
+
+	if (id == 0)
+		return;
+
+	SH_REMOVE_HOOK_ID(id);
+	id = 0;
+}
+
+void ActionProcessor::RequestHook(Action<void>* action, size_t vtableidx, bool post, size_t count)
 {
+	if (vtableidx >= ActionsPropagate::SIZE || s_handlerSlots[vtableidx] == NO_HANDLER)
+		return;
+
+	size_t slot = s_handlerSlots[vtableidx];
+	VTableHooks* hooks = FindOrHookVTable(*reinterpret_cast<void**>(action));
+
+	size_t& refs = hooks->refs[slot][post];
+
+	if (refs == 0)
+		HookHandler(hooks, slot, post);
+
+	refs += count;
+}
+
+void ActionProcessor::ReleaseHook(Action<void>* action, size_t vtableidx, bool post, size_t count)
+{
+	if (vtableidx >= ActionsPropagate::SIZE || s_handlerSlots[vtableidx] == NO_HANDLER)
+		return;
+
+	auto r = GetHookedVTables().find(*reinterpret_cast<void**>(action));
+
+	if (!r.found())
+		return;
+
+	size_t slot = s_handlerSlots[vtableidx];
+	VTableHooks* hooks = r->value;
+	size_t& refs = hooks->refs[slot][post];
+
+	refs = count < refs ? refs - count : 0;
+
+	if (refs == 0 && hooks->lazy && !s_handlerHooks[slot].required && s_handlerRefs[slot][post] == 0)
+		UnhookHandler(hooks, slot, post);
+}
+
+void ActionProcessor::RequestHandler(size_t vtableidx, bool post)
+{
+	if (vtableidx >= ActionsPropagate::SIZE || s_handlerSlots[vtableidx] == NO_HANDLER)
+		return;
+
+	size_t slot = s_handlerSlots[vtableidx];
+
+	if (s_handlerRefs[slot][post]++ != 0)
+		return;
+
+	for (auto iter = GetHookedVTables().iter(); !iter.empty(); iter.next())
+		HookHandler(iter->value, slot, post);
+}
+
+void ActionProcessor::ReleaseHandler(size_t vtableidx, bool post)
+{
+	if (vtableidx >= ActionsPropagate::SIZE || s_handlerSlots[vtableidx] == NO_HANDLER)
+		return;
+
+	size_t slot = s_handlerSlots[vtableidx];
+	size_t& refs = s_handlerRefs[slot][post];
+
+	if (refs == 0 || --refs != 0 || s_handlerHooks[slot].required)
+		return;
+
+	for (auto iter = GetHookedVTables().iter(); !iter.empty(); iter.next())
+	{
+		VTableHooks* hooks = iter->value;
+
+		if (hooks->lazy && hooks->refs[slot][post] == 0)
+			UnhookHandler(hooks, slot, post);
+	}
+}
+
+void ActionProcessor::RequestEventHandlers(bool post)
+{
+	for (const HandlerHook& handler : s_handlerHooks)
+	{
+		if (handler.event)
+			RequestHandler(handler.vtableidx, post);
+	}
+}
+
+void ActionProcessor::ReleaseEventHandlers(bool post)
+{
+	for (const HandlerHook& handler : s_handlerHooks)
+	{
+		if (handler.event)
+			ReleaseHandler(handler.vtableidx, post);
+	}
+}
+
+bool ActionProcessor::IsHandlerHooked(Action<void>* action, size_t vtableidx, bool post)
+{
+	if (vtableidx >= ActionsPropagate::SIZE || s_handlerSlots[vtableidx] == NO_HANDLER)
+		return false;
+
+	auto r = GetHookedVTables().find(*reinterpret_cast<void**>(action));
+	return r.found() && r->value->ids[s_handlerSlots[vtableidx]][post] != 0;
+}
+
+void ActionProcessor::ConfigureHandlers()
+{
+	auto& offsets = GetOffsetsInfo();
+
+	for (size_t i = 0; i < ActionsPropagate::SIZE; i++)
+		s_handlerSlots[i] = NO_HANDLER;
+
+	for (size_t slot = 0; slot < HANDLERS_COUNT; slot++)
+	{
+		HandlerHook& handler = s_handlerHooks[slot];
+		handler.vtableidx = offsets[handler.name];
+		handler.configure(handler.vtableidx, handler.name);
+
+		if (handler.vtableidx < ActionsPropagate::SIZE)
+			s_handlerSlots[handler.vtableidx] = slot;
+	}
 }
 
 void ReconfigureHooks()
@@ -224,6 +442,8 @@ void ReconfigureHooks()
 			RECONFIGURE_MANUALHOOK(OnCommandApproachEntity, 73);
 		#endif
 	#endif
+
+	ActionProcessor::ConfigureHandlers();
 }
 
 std::map<std::string, size_t>& GetOffsetsInfo()
@@ -231,3 +451,14 @@ std::map<std::string, size_t>& GetOffsetsInfo()
 	static std::map<std::string, size_t> map;
 	return map;
 }
+
+size_t GetHandlerOffset(const char* name)
+{
+	auto& offsets = GetOffsetsInfo();
+	auto iter = offsets.find(name);
+
+	if (iter == offsets.end())
+		return 0;
+
+	return iter->second;
+}
@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <vector>
+#include <string>
+
+#include "actions_profiler.h"
+#include "actions_processor.h"
+
+ActionsProfiler g_ActionsProfiler;
+ActionsProfiler* g_pActionsProfiler = &g_ActionsProfiler;
+
+ActionsProfiler::ActionsProfiler() : m_enabled(false), m_handlers()
+{
+	if (!m_plugins.init())
+	{
+		LOGERROR("Failed to init ActionsProfiler");
+	}
+}
+
+void ActionsProfiler::SetEnabled(bool enabled) noexcept
+{
+	if (enabled && !m_enabled)
+		m_since = Clock::now();
+
+	m_enabled = enabled;
+}
+
+void ActionsProfiler::Reset()
+{
+	memset(m_handlers, 0, sizeof(m_handlers));
+	m_actions.clear();
+	m_plugins.clear();
+	m_since = Clock::now();
+}
+
+void ActionsProfiler::OnDispatch(size_t vtableidx, bool post, Action<void>* action, size_t listeners)
+{
+	if (vtableidx < SIZE)
+		m_handlers[vtableidx][post].listeners += listeners;
+
+	auto i = m_actions.findForAdd(action->GetName());
+
+	if (!i.found())
+		m_actions.add(i, action->GetName(), Stats());
+
+	i->value.calls++;
+	i->value.listeners += listeners;
+}
+
+void ActionsProfiler::OnCallback(size_t vtableidx, bool post, Action<void>* action, IPluginFunction* listener, double seconds)
+{
+	if (vtableidx < SIZE)
+		m_handlers[vtableidx][post].AddCallback(seconds);
+
+	auto i = m_actions.findForAdd(action->GetName());
+
+	if (!i.found())
+		m_actions.add(i, action->GetName(), Stats());
+
+	i->value.AddCallback(seconds);
+
+	IPluginRuntime* runtime = listener->GetParentRuntime();
+	auto p = m_plugins.findForAdd(runtime);
+
+	if (!p.found())
+		m_plugins.add(p, runtime, Stats());
+
+	p->value.AddCallback(seconds);
+}
+
+void ActionsProfiler::OnPluginUnloaded(IPluginRuntime* runtime)
+{
+	auto r = m_plugins.find(runtime);
+
+	if (r.found())
+		m_plugins.remove(r);
+}
+
+void ActionsProfiler::Report()
+{
+	using Row = std::pair<std::string, Stats>;
+
+	/* Plugins aren't dispatched to, they only have callbacks */
+	auto print = [](const char* title, std::vector<Row>& rows, bool dispatches)
+	{
+		std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.second.total > b.second.total; });
+
+		LOG("/----------------------------------/");
+		LOG("%s:", title);
+
+		for (const Row& row : rows)
+		{
+			const Stats& stats = row.second;
+			double avg = stats.callbacks ? stats.total / stats.callbacks : 0.0;
+
+			if (dispatches)
+			{
+				double listeners = stats.calls ? (double)stats.listeners / stats.calls : 0.0;
+
+				LOG("%-48s calls: %-10llu listeners: %-6.2f callbacks: %-10llu total: %.3f ms, avg: %.4f ms, max: %.4f ms", row.first.c_str(),
+					stats.calls, listeners, stats.callbacks, stats.total * 1000.0, avg * 1000.0, stats.max * 1000.0);
+			}
+			else
+			{
+				LOG("%-48s callbacks: %-10llu total: %.3f ms, avg: %.4f ms, max: %.4f ms", row.first.c_str(),
+					stats.callbacks, stats.total * 1000.0, avg * 1000.0, stats.max * 1000.0);
+			}
+		}
+	};
+
+	std::chrono::duration<double> elapsed = Clock::now() - m_since;
+	LOG("Profiler is %s, collecting for %.1f seconds", m_enabled ? "enabled" : "disabled", elapsed.count());
+
+	std::vector<Row> rows;
+	auto& offsets = GetOffsetsInfo();
+
+	for (auto& offset : offsets)
+	{
+		if (offset.second >= SIZE)
+			continue;
+
+		for (int post = 0; post < 2; post++)
+		{
+			const Stats& stats = m_handlers[offset.second][post];
+
+			if (stats.calls == 0 && stats.callbacks == 0)
+				continue;
+
+			rows.push_back({ offset.first + (post ? " (post)" : ""), stats });
+		}
+	}
+
+	print("Handlers", rows, true);
+	rows.clear();
+
+	for (auto iter = m_actions.iter(); !iter.empty(); iter.next())
+		rows.push_back({ iter->key, iter->value });
+
+	print("Actions", rows, true);
+	rows.clear();
+
+	for (auto iter = m_plugins.iter(); !iter.empty(); iter.next())
+	{
+		IPlugin* plugin = plsys->FindPluginByContext(iter->key->GetDefaultContext()->GetContext());
+		rows.push_back({ plugin ? plugin->GetFilename() : "<unknown>", iter->value });
+	}
+
+	print("Plugins", rows, false);
+}
@@ -1,14 +1,18 @@
 #include <utility>
+#include <algorithm>
 
 #include "extension.h"
 #include "actions_propagate.h"
+#include "actions_processor.h"
+#include "actions_names.h"
 
-ActionsPropagate* g_pActionsPropagatePre = new ActionsPropagate();
-ActionsPropagate* g_pActionsPropagatePost = new ActionsPropagate();
 
-ActionsPropagate::ActionsPropagate()
+ActionsPropagate* g_pActionsPropagatePre = new ActionsPropagate(false);
+ActionsPropagate* g_pActionsPropagatePost = new ActionsPropagate(true);
+
+ActionsPropagate::ActionsPropagate(bool post) : m_listeners(), m_post(post)
 {
-	m_init = m_handlers.init();
+	m_init = m_handlers.init() && m_contexts.init() && m_named.init() && m_namedActions.init() && m_throttles.init();
 
 	if (!m_init)
 	{
@@ -16,20 +20,22 @@ ActionsPropagate::ActionsPropagate()
 	}
 }
 
-bool ActionsPropagate::AddListener(size_t vtableidx, Action* action, IPluginFunction* listener)
+bool ActionsPropagate::AddListener(size_t vtableidx, Action* action, IPluginFunction* listener, int priority, float interval, bool stop)
 {
 	auto i = m_handlers.findForAdd(action);
 
 	if (!i.found())
 	{
-		m_handlers.add(i, action, HandlersArray(SIZE));
+		m_handlers.add(i, action, ActionHandlers());
 	}
 	else if (FindListener(vtableidx, action, listener))
 	{
 		return false;
 	}
 
-	i->value[vtableidx].push_back(listener);
+	InsertCallback(i->value.FindOrAdd(vtableidx), listener, priority, interval, stop);
+	IndexListener(vtableidx, action, GetListenerContext(listener));
+	OnListenerAdded(vtableidx, action, i->value);
 	return true;
 }
 
@@ -40,12 +46,19 @@ bool ActionsPropagate::RemoveListener(size_t vtableidx, Action* action, IPluginF
 	if (!r.found())
 		return false;
 
-	PluginCallbacks::iterator iterator;
-	if (FindListener(vtableidx, action, listener, &iterator))
+	PluginCallbacks* listeners = r->value.Find(vtableidx);
+
+	if (listeners == NULL)
+		return false;
+
+	for (auto iter = listeners->begin(); iter != listeners->end(); iter++)
 	{
-		auto& listeners = r->value[vtableidx];
-		listeners.erase(iterator);
+		if (*iter != listener)
+			continue;
 
+		listeners->erase(iter);
+		UnindexListener(action, GetListenerContext(listener));
+		OnListenersRemoved(vtableidx, action, r->value);
 		return true;
 	}
 
@@ -59,20 +72,45 @@ bool ActionsPropagate::RemoveListener(size_t vtableidx, Action* action, IPluginC
 	if (!r.found())
 		return false;
 	
-	auto& listeners = r->value[vtableidx];
+	return RemoveListener(vtableidx, action, r->value, context);
+}
 
-	for (auto iter = listeners.begin(); iter != listeners.end(); iter++)
+bool ActionsPropagate::RemoveListener(size_t vtableidx, Action* action, ActionHandlers& handlers, IPluginContext* context)
+{
+	PluginCallbacks* listeners = handlers.Find(vtableidx);
+
+	if (listeners == NULL)
+		return false;
+
+	for (auto iter = listeners->begin(); iter != listeners->end(); iter++)
 	{
-		if ((*iter)->GetParentRuntime()->GetDefaultContext() != context)
+		if (GetListenerContext(*iter) != context)
 			continue;
 
-		listeners.erase(iter);
+		listeners->erase(iter);
+		UnindexListener(action, context);
+		OnListenersRemoved(vtableidx, action, handlers);
 		return true;
 	}
 
 	return false;
 }
 
+void ActionsPropagate::RemoveListeners(Action* action, ActionHandlers& handlers, const std::bitset<SIZE>& mask, IPluginContext* context)
+{
+	for (auto& handler : handlers.handlers)
+	{
+		if (handlers.listeners == 0)
+			break;
+
+		if (!mask.test(handler.vtableidx))
+			continue;
+
+		while (RemoveListener(handler.vtableidx, action, handlers, context))
+			;
+	}
+}
+
 void ActionsPropagate::RemoveListeners(Action* action)
 {
 	auto r = m_handlers.find(action);
@@ -80,41 +118,120 @@ void ActionsPropagate::RemoveListeners(Action* action)
 	if (!r.found())
 		return;
 	
-	const size_t size = r->value.size();
-	for (size_t i = 0; i < size; i++)
+	UnindexAction(action, r->value);
+
+	for (auto& handler : r->value.handlers)
 	{
-		r->value[i].clear();
+		if (handler.callbacks.size() == 0)
+			continue;
+
+		OnListenersRemoved(handler.vtableidx, action, r->value, handler.callbacks.size());
 	}
+
+	m_handlers.remove(r);
 }
 
 void ActionsPropagate::RemoveListeners(Action* action, IPluginContext* context)
 {
+	auto c = m_contexts.find(context);
+
+	if (!c.found())
+		return;
+
+	auto a = c->value->find(action);
+
+	if (!a.found())
+		return;
+
 	auto r = m_handlers.find(action);
 
 	if (!r.found())
 		return;
-	
-	const size_t size = r->value.size();
-	for (size_t i = 0; i < size; i++)
-	{
-		RemoveListener(i, action, context);
-	}
+
+	/* Copy, entry is erased once last listener of this plugin is removed */
+	std::bitset<SIZE> mask = a->value.mask;
+	RemoveListeners(action, r->value, mask, context);
 }
 
 void ActionsPropagate::RemoveListeners(IPluginContext* context)
 {
-	auto iter = m_handlers.iter();
+	auto c = m_contexts.find(context);
 
-	while (!iter.empty())
+	if (c.found())
 	{
-		const size_t size = iter->value.size();
-		for (size_t i = 0; i < size; i++)
+		/* Detach index first, removals below don't have to maintain it */
+		ContextActions* actions = c->value;
+		m_contexts.remove(c);
+
+		for (auto iter = actions->iter(); !iter.empty(); iter.next())
 		{
-			RemoveListener(i, iter->key, context);
+			auto r = m_handlers.find(iter->key);
+
+			if (r.found())
+				RemoveListeners(iter->key, r->value, iter->value.mask, context);
 		}
 
-		iter.next();
+		delete actions;
+	}
+
+	RemoveNamedListeners(context);
+	RemoveThrottles(context);
+}
+
+bool ActionsPropagate::PassThrottle(Action* action, size_t vtableidx, const PluginCallback& callback, float now)
+{
+	auto i = m_throttles.findForAdd(action);
+
+	if (!i.found())
+		m_throttles.add(i, action, ThrottleStates());
+
+	for (ThrottleState& state : i->value)
+	{
+		if (state.listener != callback.function || state.vtableidx != vtableidx)
+			continue;
+
+		/* Game time goes back on map change, don't wait for old deadline then */
+		if (now < state.next && state.next - now <= callback.interval)
+			return false;
+
+		state.next = now + callback.interval;
+		return true;
+	}
+
+	i->value.push_back({ callback.function, (uint32_t)vtableidx, now + callback.interval });
+	return true;
+}
+
+void ActionsPropagate::RemoveThrottles(Action* action)
+{
+	if (m_throttles.elements() == 0)
+		return;
+
+	auto r = m_throttles.find(action);
+
+	if (r.found())
+		m_throttles.remove(r);
+}
+
+void ActionsPropagate::RemoveThrottles(IPluginContext* context)
+{
+	std::vector<Action*> unused;
+
+	for (auto iter = m_throttles.iter(); !iter.empty(); iter.next())
+	{
+		ThrottleStates& states = iter->value;
+
+		states.erase(std::remove_if(states.begin(), states.end(), [context](const ThrottleState& state)
+		{
+			return GetListenerContext(state.listener) == context;
+		}), states.end());
+
+		if (states.empty())
+			unused.push_back(iter->key);
 	}
+
+	for (Action* action : unused)
+		RemoveThrottles(action);
 }
 
 bool ActionsPropagate::FindListener(size_t vtableidx, Action* action, IPluginFunction* listener, PluginCallbacks::iterator* iterator)
@@ -124,9 +241,12 @@ bool ActionsPropagate::FindListener(size_t vtableidx, Action* action, IPluginFun
 	if (!r.found())
 		return false;
 
-	auto& listeners = r->value[vtableidx];
+	PluginCallbacks* listeners = r->value.Find(vtableidx);
+
+	if (listeners == NULL)
+		return false;
 
-	for (auto iter = listeners.begin(); iter != listeners.end(); iter++)
+	for (auto iter = listeners->begin(); iter != listeners->end(); iter++)
 	{
 		if (*iter != listener)
 			continue;
@@ -157,13 +277,301 @@ bool ActionsPropagate::FindListener(size_t vtableidx, IPluginFunction* listener,
 	return false;
 }
 
-void ActionsPropagate::OnActionAdded(Action* action)
+bool ActionsPropagate::AddNamedListener(size_t vtableidx, const char* name, IPluginFunction* listener, int priority, float interval, bool stop)
+{
+	NamedHandlers* named = NULL;
+	bool created = false;
+
+	const uint32_t id = g_pActionsNames->Intern(name);
+	auto i = m_named.findForAdd(id);
+
+	if (i.found())
+	{
+		named = i->value;
+	}
+	else
+	{
+		named = new NamedHandlers();
+		named->name = name;
+		named->nameId = id;
+
+		m_named.add(i, id, named);
+		m_namedList.push_back(named);
+		created = true;
+	}
+
+	PluginCallbacks& callbacks = named->handlers.FindOrAdd(vtableidx);
+
+	for (IPluginFunction* callback : callbacks)
+	{
+		if (callback == listener)
+			return false;
+	}
+
+	InsertCallback(callbacks, listener, priority, interval, stop);
+	named->handlers.listeners++;
+	m_listeners[vtableidx]++;
+
+	if (created)
+	{
+		/* Bind actions that are alive already, new ones are bound when created */
+		g_pActionsManager->ForEachAction([&](Action* action)
+		{
+			if (g_pActionsNames->GetNameId(action) == id)
+				BindNamedHandlers(action, named);
+		});
+
+		return true;
+	}
+
+	for (auto iter = m_namedActions.iter(); !iter.empty(); iter.next())
+	{
+		if (iter->value == named)
+			ActionProcessor::RequestHook(iter->key, vtableidx, m_post);
+	}
+
+	return true;
+}
+
+bool ActionsPropagate::RemoveNamedListener(size_t vtableidx, const char* name, IPluginFunction* listener)
+{
+	auto r = m_named.find(g_pActionsNames->Lookup(name));
+
+	if (!r.found())
+		return false;
+
+	NamedHandlers* named = r->value;
+
+	PluginCallbacks* callbacks = named->handlers.Find(vtableidx);
+
+	if (callbacks == NULL)
+		return false;
+
+	for (auto iter = callbacks->begin(); iter != callbacks->end(); iter++)
+	{
+		if (*iter != listener)
+			continue;
+
+		callbacks->erase(iter);
+		named->handlers.listeners--;
+		m_listeners[vtableidx]--;
+
+		for (auto bound = m_namedActions.iter(); !bound.empty(); bound.next())
+		{
+			if (bound->value == named)
+				ActionProcessor::ReleaseHook(bound->key, vtableidx, m_post);
+		}
+
+		if (named->handlers.listeners == 0)
+			DestroyNamedHandlers(named);
+
+		return true;
+	}
+
+	return false;
+}
+
+void ActionsPropagate::RemoveNamedListeners(IPluginContext* context)
+{
+	std::vector<NamedHandlers*> named = m_namedList;
+
+	for (NamedHandlers* handlers : named)
+	{
+		for (auto& handler : handlers->handlers.handlers)
+		{
+			size_t removed = 0;
+
+			for (auto iter = handler.callbacks.begin(); iter != handler.callbacks.end();)
+			{
+				if ((*iter)->GetParentRuntime()->GetDefaultContext() != context)
+				{
+					iter++;
+					continue;
+				}
+
+				iter = handler.callbacks.erase(iter);
+				removed++;
+			}
+
+			if (removed == 0)
+				continue;
+
+			handlers->handlers.listeners -= removed;
+			m_listeners[handler.vtableidx] -= removed;
+
+			for (auto bound = m_namedActions.iter(); !bound.empty(); bound.next())
+			{
+				if (bound->value == handlers)
+					ActionProcessor::ReleaseHook(bound->key, handler.vtableidx, m_post, removed);
+			}
+		}
+
+		if (handlers->handlers.listeners == 0)
+			DestroyNamedHandlers(handlers);
+	}
+}
+
+void ActionsPropagate::DestroyNamedHandlers(NamedHandlers* named)
+{
+	std::vector<Action*> bound;
+
+	for (auto iter = m_namedActions.iter(); !iter.empty(); iter.next())
+	{
+		if (iter->value == named)
+			bound.push_back(iter->key);
+	}
+
+	for (Action* action : bound)
+	{
+		auto r = m_namedActions.find(action);
+		m_namedActions.remove(r);
+	}
+
+	auto r = m_named.find(named->nameId);
+	m_named.remove(r);
+	m_namedList.erase(std::find(m_namedList.begin(), m_namedList.end(), named));
+	delete named;
+}
+
+void ActionsPropagate::BindNamedHandlers(Action* action, NamedHandlers* named)
+{
+	auto i = m_namedActions.findForAdd(action);
+
+	if (i.found())
+		return;
+
+	m_namedActions.add(i, action, named);
+
+	for (auto& handler : named->handlers.handlers)
+	{
+		if (handler.callbacks.size() == 0)
+			continue;
+
+		ActionProcessor::RequestHook(action, handler.vtableidx, m_post, handler.callbacks.size());
+	}
+}
+
+void ActionsPropagate::BindNamedHandlers(Action* action)
+{
+	if (m_named.elements() == 0)
+		return;
+
+	auto r = m_named.find(g_pActionsNames->GetNameId(action));
+
+	if (!r.found())
+		return;
+
+	BindNamedHandlers(action, r->value);
+}
+
+void ActionsPropagate::UnbindNamedHandlers(Action* action)
+{
+	if (m_namedActions.elements() == 0)
+		return;
+
+	auto r = m_namedActions.find(action);
+
+	if (!r.found())
+		return;
+
+	for (auto& handler : r->value->handlers.handlers)
+	{
+		if (handler.callbacks.size() == 0)
+			continue;
+
+		ActionProcessor::ReleaseHook(action, handler.vtableidx, m_post, handler.callbacks.size());
+	}
+
+	m_namedActions.remove(r);
+}
+
+void ActionsPropagate::IndexListener(size_t vtableidx, Action* action, IPluginContext* context)
+{
+	auto c = m_contexts.findForAdd(context);
+
+	if (!c.found())
+	{
+		ContextActions* actions = new ContextActions();
+		actions->init();
+
+		m_contexts.add(c, context, actions);
+	}
+
+	auto a = c->value->findForAdd(action);
+
+	if (!a.found())
+		c->value->add(a, action, ContextListeners());
+
+	a->value.mask.set(vtableidx);
+	a->value.count++;
+}
+
+void ActionsPropagate::UnindexListener(Action* action, IPluginContext* context)
+{
+	auto c = m_contexts.find(context);
+
+	if (!c.found())
+		return;
+
+	auto a = c->value->find(action);
+
+	if (!a.found())
+		return;
+
+	if (--a->value.count != 0)
+		return;
+
+	c->value->remove(a);
+
+	if (c->value->elements() == 0)
+	{
+		delete c->value;
+		m_contexts.remove(c);
+	}
+}
+
+void ActionsPropagate::UnindexAction(Action* action, ActionHandlers& handlers)
 {
+	if (m_contexts.elements() == 0)
+		return;
 
+	for (auto& handler : handlers.handlers)
+	{
+		for (IPluginFunction* callback : handler.callbacks)
+			UnindexListener(action, GetListenerContext(callback));
+	}
+}
+
+void ActionsPropagate::OnListenerAdded(size_t vtableidx, Action* action, ActionHandlers& handlers)
+{
+	handlers.listeners++;
+	m_listeners[vtableidx]++;
+
+	ActionProcessor::RequestHook(action, vtableidx, m_post);
+}
+
+void ActionsPropagate::OnListenersRemoved(size_t vtableidx, Action* action, ActionHandlers& handlers, size_t count)
+{
+	handlers.listeners -= count;
+	m_listeners[vtableidx] -= count;
+
+	ActionProcessor::ReleaseHook(action, vtableidx, m_post, count);
+}
+
+void ActionsPropagate::OnActionAdded(Action* action)
+{
+	g_pActionsPropagatePre->BindNamedHandlers(action);
+	g_pActionsPropagatePost->BindNamedHandlers(action);
 }
 
 void ActionsPropagate::OnActionDestroyed(Action* action)
 {
 	g_pActionsPropagatePre->RemoveListeners(action);
 	g_pActionsPropagatePost->RemoveListeners(action);
+
+	g_pActionsPropagatePre->RemoveThrottles(action);
+	g_pActionsPropagatePost->RemoveThrottles(action);
+
+	g_pActionsPropagatePre->UnbindNamedHandlers(action);
+	g_pActionsPropagatePost->UnbindNamedHandlers(action);
 }
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include <cstdio>
+
+#include "actions_recorder.h"
+#include "actions_manager.h"
+#include "actions_names.h"
+
+ConVar ext_actions_recorder("ext_actions_recorder", "1", FCVAR_NONE, "Record action transitions into ring buffer, dump with ext_actions_recorder_dump");
+
+ActionsRecorder g_ActionsRecorder;
+ActionsRecorder* g_pActionsRecorder = &g_ActionsRecorder;
+
+ActionsRecorder::ActionsRecorder() : m_records(), m_next(0), m_count(0)
+{
+	/* Reserve index 0 for "no plugin" */
+	m_pluginNames.emplace_back("-");
+
+	if (!m_plugins.init())
+	{
+		LOGERROR("Failed to init ActionsRecorder");
+	}
+}
+
+ActionsRecorder::Record& ActionsRecorder::Push(RecordType type, cell_t entity, Action<void>* action)
+{
+	Record& record = m_records[m_next];
+
+	m_next = (m_next + 1) % CAPACITY;
+
+	if (m_count < CAPACITY)
+		m_count++;
+
+	record.tick = gpGlobals->tickcount;
+	record.nameId = g_pActionsNames->GetNameId(action);
+	record.targetId = ActionsNames::INVALID_NAME_ID;
+	record.entity = static_cast<uint16_t>(entity);
+	record.plugin = 0;
+	record.type = type;
+	record.handler = 0;
+	record.result = 0;
+	record.post = 0;
+	return record;
+}
+
+void ActionsRecorder::OnActionAdded(cell_t entity, Action<void>* action)
+{
+	if (IsEnabled())
+		Push(RecordType::Added, entity, action);
+}
+
+void ActionsRecorder::OnActionRemoved(cell_t entity, Action<void>* action)
+{
+	if (IsEnabled())
+		Push(RecordType::Removed, entity, action);
+}
+
+void ActionsRecorder::OnActionResult(Action<void>* action, size_t vtableidx, ActionResultType type, Action<void>* target)
+{
+	if (!IsEnabled())
+		return;
+
+	Record& record = Push(RecordType::Result, g_pActionsManager->GetActionOwner(action), action);
+
+	record.handler = static_cast<uint8_t>(vtableidx);
+	record.result = static_cast<uint8_t>(type);
+
+	if (target)
+		record.targetId = g_pActionsNames->GetNameId(target);
+}
+
+void ActionsRecorder::OnHandlerChanged(Action<void>* action, size_t vtableidx, bool post, ResultType result, IPluginFunction* changer)
+{
+	if (!IsEnabled())
+		return;
+
+	Record& record = Push(RecordType::Handler, g_pActionsManager->GetActionOwner(action), action);
+
+	record.handler = static_cast<uint8_t>(vtableidx);
+	record.result = static_cast<uint8_t>(result);
+	record.post = post;
+	record.plugin = GetPluginIndex(changer);
+}
+
+uint16_t ActionsRecorder::GetPluginIndex(IPluginFunction* function)
+{
+	if (function == NULL)
+		return 0;
+
+	IPluginRuntime* runtime = function->GetParentRuntime();
+	auto i = m_plugins.findForAdd(runtime);
+
+	if (i.found())
+		return i->value;
+
+	if (m_pluginNames.size() > UINT16_MAX)
+		return 0;
+
+	IPlugin* plugin = plsys->FindPluginByContext(runtime->GetDefaultContext()->GetContext());
+	uint16_t index = static_cast<uint16_t>(m_pluginNames.size());
+
+	m_pluginNames.emplace_back(plugin ? plugin->GetFilename() : "<unknown>");
+	m_plugins.add(i, runtime, index);
+	return index;
+}
+
+void ActionsRecorder::OnPluginUnloaded(IPluginRuntime* runtime)
+{
+	auto r = m_plugins.find(runtime);
+
+	if (r.found())
+		m_plugins.remove(r);
+}
+
+void ActionsRecorder::Clear() noexcept
+{
+	m_next = 0;
+	m_count = 0;
+}
+
+bool ActionsRecorder::DumpCSV(const char* path) const
+{
+	static const char* types[] = { "added", "removed", "result", "handler" };
+
+	FILE* file = fopen(path, "w");
+
+	if (file == NULL)
+		return false;
+
+	fprintf(file, "tick,type,entity,action,handler,post,result,target,plugin\n");
+
+	ForEachRecord([&](const Record& record)
+	{
+		const char* name = g_pActionsNames->GetName(record.nameId);
+		const char* target = g_pActionsNames->GetName(record.targetId);
+
+		fprintf(file, "%i,%s,%i,%s,%i,%i,%i,%s,%s\n",
+			record.tick,
+			types[static_cast<size_t>(record.type)],
+			record.entity,
+			name ? name : "",
+			record.handler,
+			record.post,
+			record.result,
+			target ? target : "",
+			m_pluginNames[record.plugin].c_str());
+	});
+
+	fclose(file);
+	return true;
+}
+
+bool ActionsRecorder::DumpBinary(const char* path) const
+{
+	FILE* file = fopen(path, "wb");
+
+	if (file == NULL)
+		return false;
+
+	/* Header, records, then name and plugin tables so ids can be resolved offline */
+	const uint32_t header[] = { MAGIC, VERSION, sizeof(Record), static_cast<uint32_t>(m_count) };
+	fwrite(header, sizeof(header), 1, file);
+
+	ForEachRecord([&](const Record& record)
+	{
+		fwrite(&record, sizeof(Record), 1, file);
+	});
+
+	auto writeString = [file](const char* string)
+	{
+		const uint16_t length = static_cast<uint16_t>(strlen(string));
+		fwrite(&length, sizeof(length), 1, file);
+		fwrite(string, length, 1, file);
+	};
+
+	const uint32_t names = static_cast<uint32_t>(g_pActionsNames->GetCount());
+	fwrite(&names, sizeof(names), 1, file);
+
+	for (uint32_t id = 1; id <= names; id++)
+		writeString(g_pActionsNames->GetName(id));
+
+	const uint32_t plugins = static_cast<uint32_t>(m_pluginNames.size());
+	fwrite(&plugins, sizeof(plugins), 1, file);
+
+	for (const std::string& plugin : m_pluginNames)
+		writeString(plugin.c_str());
+
+	fclose(file);
+	return true;
+}
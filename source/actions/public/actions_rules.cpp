@@ -0,0 +1,161 @@
+#include <cstring>
+
+#include "extension.h"
+
+#include "actions_rules.h"
+#include "actions_manager.h"
+#include "actions_names.h"
+#include "actions_custom.h"
+#include "actions_processor.h"
+
+ActionsRules g_ActionsRules;
+ActionsRules* g_pActionsRules = &g_ActionsRules;
+
+/* Handlers that don't return action result, rules can't answer for them */
+static const char* s_unsupportedHandlers[] =
+{
+	"OnDestroyed",
+	"OnEnd",
+	"OnInitialContainedAction",
+	"IsAbleToBlockMovementOf"
+};
+
+ActionsRules::ActionsRules() : m_mask()
+{
+}
+
+ActionsRules::~ActionsRules()
+{
+	for (char* reason : m_reasons)
+		delete[] reason;
+
+	m_reasons.clear();
+}
+
+void ActionsRules::Clear()
+{
+	for (size_t vtableidx = 0; vtableidx < SIZE; vtableidx++)
+	{
+		if (!m_mask.test(vtableidx))
+			continue;
+
+		m_rules[vtableidx].clear();
+		ActionProcessor::ReleaseHandler(vtableidx, false);
+	}
+
+	m_mask.reset();
+}
+
+bool ActionsRules::Add(const char* handler, Rule& rule)
+{
+	for (const char* name : s_unsupportedHandlers)
+	{
+		if (strcmp(name, handler) == 0)
+		{
+			LOGERROR("Rule \"%s\": handler \"%s\" doesn't return action result", rule.name.c_str(), handler);
+			return false;
+		}
+	}
+
+	size_t vtableidx = GetHandlerOffset(handler);
+
+	if (vtableidx == 0 || vtableidx >= SIZE)
+	{
+		LOGERROR("Rule \"%s\": unknown event handler \"%s\"", rule.name.c_str(), handler);
+		return false;
+	}
+
+	rule.handler = handler;
+
+	if (!m_mask.test(vtableidx))
+	{
+		m_mask.set(vtableidx);
+		ActionProcessor::RequestHandler(vtableidx, false);
+	}
+
+	m_rules[vtableidx].push_back(rule);
+	return true;
+}
+
+const char* ActionsRules::StoreReason(const char* reason)
+{
+	if (reason == NULL || reason[0] == '\0')
+		return NULL;
+
+	for (const char* stored : m_reasons)
+	{
+		if (strcmp(stored, reason) == 0)
+			return stored;
+	}
+
+	size_t length = strlen(reason) + 1;
+	char* stored = new char[length];
+	memcpy(stored, reason, length);
+
+	m_reasons.push_back(stored);
+	return stored;
+}
+
+ActionsRules::Rule* ActionsRules::Match(size_t vtableidx, Action<void>* action)
+{
+	std::vector<Rule>& rules = m_rules[vtableidx];
+	const uint32_t nameId = g_pActionsNames->GetNameId(action);
+	uint32_t intentionId = ActionsNames::INVALID_NAME_ID;
+	bool intentionKnown = false;
+
+	/* First matching rule wins, they are kept in file order */
+	for (Rule& rule : rules)
+	{
+		if (rule.nameId != nameId)
+			continue;
+
+		if (rule.intentionId != ActionsNames::INVALID_NAME_ID)
+		{
+			if (!intentionKnown)
+			{
+				intentionId = g_pActionsManager->GetEntityIntention(static_cast<CBaseEntity*>(action->GetActor()));
+				intentionKnown = true;
+			}
+
+			if (rule.intentionId != intentionId)
+				continue;
+		}
+
+		rule.hits++;
+		return &rule;
+	}
+
+	return NULL;
+}
+
+Action<void>* ActionsRules::CreateReplacement(const Rule* rule)
+{
+	if (rule->replacement == NULL)
+		return NULL;
+
+	return g_pActionClasses->Create(rule->replacement);
+}
+
+void ActionsRules::Dump() const
+{
+	static const char* s_types[] = { "continue", "change_to", "suspend_for", "done", "sustain" };
+	size_t count = 0;
+
+	for (size_t vtableidx = 0; vtableidx < SIZE; vtableidx++)
+	{
+		for (const Rule& rule : m_rules[vtableidx])
+		{
+			LOG("%s: %s::%s -> %s %s (%llu hits)",
+				rule.name.c_str(),
+				g_pActionsNames->GetName(rule.nameId),
+				rule.handler.c_str(),
+				s_types[rule.type],
+				rule.replacement ? rule.replacement->name.c_str() : "-",
+				(unsigned long long)rule.hits);
+
+			count++;
+		}
+	}
+
+	LOG("%u rules", (unsigned)count);
+}
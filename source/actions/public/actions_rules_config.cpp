@@ -0,0 +1,130 @@
+#include <cstring>
+
+#include "extension.h"
+
+#include "actions_rules.h"
+#include "actions_names.h"
+#include "actions_custom.h"
+
+#include <KeyValues.h>
+
+/*
+ * "ActionRules"
+ * {
+ *     "<rule name>"
+ *     {
+ *         "action"      "TankAttack"       // required
+ *         "handler"     "OnStart"          // required, any handler returning action result
+ *         "intention"   "TankIntention"    // optional, see gamedata Keys for names
+ *         "result"      "change_to"        // continue, change_to, suspend_for, done or sustain
+ *         "class"       "MyTankAttack"     // action class created for change_to and suspend_for
+ *         "priority"    "try"              // event handlers only: try, important, critical
+ *         "reason"      "..."
+ *     }
+ * }
+ */
+
+static bool ParseResultType(const char* value, ActionResultType& type)
+{
+	static const char* s_types[] = { "continue", "change_to", "suspend_for", "done", "sustain" };
+
+	for (size_t i = 0; i < sizeof(s_types) / sizeof(s_types[0]); i++)
+	{
+		if (strcmp(s_types[i], value) == 0)
+		{
+			type = static_cast<ActionResultType>(i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool ParsePriority(const char* value, EventResultPriorityType& priority)
+{
+	static const char* s_priorities[] = { "none", "try", "important", "critical" };
+
+	for (size_t i = 0; i < sizeof(s_priorities) / sizeof(s_priorities[0]); i++)
+	{
+		if (strcmp(s_priorities[i], value) == 0)
+		{
+			priority = static_cast<EventResultPriorityType>(i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool ActionsRules::Load()
+{
+	char path[PLATFORM_MAX_PATH];
+	smutils->BuildPath(Path_SM, path, sizeof(path), "configs/actions_rules.cfg");
+
+	KeyValues* kv = new KeyValues("ActionRules");
+
+	if (!kv->LoadFromFile(basefilesystem, path))
+	{
+		kv->deleteThis();
+		LOGDEBUG("Rules file \"%s\" wasn't loaded", path);
+		return false;
+	}
+
+	Clear();
+
+	size_t count = 0;
+
+	for (KeyValues* section = kv->GetFirstTrueSubKey(); section != NULL; section = section->GetNextTrueSubKey())
+	{
+		Rule rule = {};
+		rule.name = section->GetName();
+		rule.priority = RESULT_TRY;
+
+		const char* action = section->GetString("action");
+		const char* handler = section->GetString("handler");
+		const char* intention = section->GetString("intention");
+		const char* result = section->GetString("result", "continue");
+		const char* className = section->GetString("class");
+		const char* priority = section->GetString("priority");
+
+		if (action[0] == '\0' || handler[0] == '\0')
+		{
+			LOGERROR("Rule \"%s\": \"action\" and \"handler\" are required", rule.name.c_str());
+			continue;
+		}
+
+		if (!ParseResultType(result, rule.type))
+		{
+			LOGERROR("Rule \"%s\": unknown result \"%s\"", rule.name.c_str(), result);
+			continue;
+		}
+
+		if (priority[0] != '\0' && !ParsePriority(priority, rule.priority))
+		{
+			LOGERROR("Rule \"%s\": unknown priority \"%s\"", rule.name.c_str(), priority);
+			continue;
+		}
+
+		if (rule.type == CHANGE_TO || rule.type == SUSPEND_FOR)
+		{
+			if (className[0] == '\0')
+			{
+				LOGERROR("Rule \"%s\": %s needs replacement \"class\"", rule.name.c_str(), result);
+				continue;
+			}
+
+			rule.replacement = g_pActionClasses->Get(g_pActionClasses->Register(className));
+		}
+
+		rule.nameId = g_pActionsNames->Intern(action);
+		rule.intentionId = intention[0] != '\0' ? g_pActionsNames->Intern(intention) : ActionsNames::INVALID_NAME_ID;
+		rule.reason = StoreReason(section->GetString("reason"));
+
+		if (Add(handler, rule))
+			count++;
+	}
+
+	kv->deleteThis();
+	LOG("Loaded %u action rules", (unsigned)count);
+	return true;
+}
@@ -0,0 +1,122 @@
+#include "actions_userdata.h"
+
+ActionsUserData g_ActionsUserData;
+ActionsUserData* g_pActionsUserData = &g_ActionsUserData;
+
+ActionsUserData::ActionsUserData() : m_nextKey(0)
+{
+	if (!m_data.init())
+	{
+		LOGERROR("Failed to init ActionsUserData");
+	}
+}
+
+uint32_t ActionsUserData::InternKey(const char* key)
+{
+	auto i = m_keys.findForAdd(key);
+
+	if (i.found())
+		return i->value;
+
+	m_keys.add(i, key, m_nextKey);
+	return m_nextKey++;
+}
+
+bool ActionsUserData::FindKey(const char* key, uint32_t* id)
+{
+	return m_keys.retrieve(key, id);
+}
+
+ActionsUserData::Entry& ActionsUserData::Set(Action* action, uint32_t key, DataType type)
+{
+	auto i = m_data.findForAdd(action);
+
+	if (!i.found())
+		m_data.add(i, action, Entries());
+
+	Entries& entries = i->value;
+
+	for (Entry& entry : entries)
+	{
+		if (entry.key != key)
+			continue;
+
+		entry.type = type;
+		entry.array.clear();
+		entry.string.clear();
+		return entry;
+	}
+
+	entries.push_back({ key, type, 0 });
+	return entries.back();
+}
+
+const ActionsUserData::Entry* ActionsUserData::Get(Action* action, uint32_t key) const
+{
+	if (m_data.elements() == 0)
+		return NULL;
+
+	auto r = m_data.find(action);
+
+	if (!r.found())
+		return NULL;
+
+	for (const Entry& entry : r->value)
+	{
+		if (entry.key == key)
+			return &entry;
+	}
+
+	return NULL;
+}
+
+bool ActionsUserData::Remove(Action* action, uint32_t key)
+{
+	auto r = m_data.find(action);
+
+	if (!r.found())
+		return false;
+
+	Entries& entries = r->value;
+
+	for (auto iter = entries.begin(); iter != entries.end(); iter++)
+	{
+		if (iter->key != key)
+			continue;
+
+		entries.erase(iter);
+
+		if (entries.empty())
+			m_data.remove(r);
+
+		return true;
+	}
+
+	return false;
+}
+
+void ActionsUserData::OnActionDestroyed(Action* action)
+{
+	if (m_data.elements() == 0)
+		return;
+
+	auto r = m_data.find(action);
+
+	if (r.found())
+		m_data.remove(r);
+}
+
+size_t ActionsUserData::GetMemoryUsage() const
+{
+	size_t usage = m_data.estimateMemoryUse();
+
+	for (auto iter = m_data.iter(); !iter.empty(); iter.next())
+	{
+		usage += iter->value.capacity() * sizeof(Entry);
+
+		for (const Entry& entry : iter->value)
+			usage += entry.array.capacity() * sizeof(cell_t) + entry.string.capacity();
+	}
+
+	return usage;
+}
@@ -6,6 +6,7 @@
 class CExtBehaviorActions : public SDKExtension, public IPluginsListener, public IConCommandBaseAccessor
 {
 public:
+	virtual void OnPluginLoaded(IPlugin* plugin) override;
 	virtual void OnPluginUnloaded(IPlugin* plugin) override;
 
 	virtual bool SDK_OnLoad(char *error, size_t maxlen, bool late) override;
@@ -22,10 +23,16 @@ public:
 	// virtual bool SDK_OnMetamodUnload(char *error, size_t maxlen);
 	// virtual bool SDK_OnMetamodPauseChange(bool paused, char *error, size_t maxlen);
 #endif
+
+private:
+	bool m_late = false;
 };
 
 extern IGameConfig* g_pGameConf;
 extern CGlobalVars *gpGlobals;
 extern ICvar *icvar;
 
+class IBaseFileSystem;
+extern IBaseFileSystem* basefilesystem;
+
 #endif // _INCLUDE_SOURCEMOD_EXTENSION_PROPER_H_
\ No newline at end of file
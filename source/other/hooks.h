@@ -2,6 +2,7 @@
 
 #include "NextBotEventResponderInterface.h"
 #include "NextBotInterface.h"
+#include "NextBotManager.h"
 
 class NextBotIntention : public IIntention
 {
@@ -16,9 +17,57 @@ public:
 
 SH_DECL_MANUALHOOK0_void(OnIntentionReset, INTENTION_RESET_OFFSET, 0, 0);
 
+/* Per intention type switch, read from "Keys" section of gamedata */
+enum class IntentionTracking
+{
+	Track,		// hook Reset and capture actions
+	Ignore,		// hook Reset only to keep bot out of manager, its actions are neither captured nor hooked
+	Off			// don't hook Reset, actions are still captured if bot runs action class hooked for other type
+};
+
+struct IntentionType
+{
+	const char* name;
+	const char* address;
+	bool survivor;		// has sub behavior
+	IntentionTracking tracking;
+	void* vtable;
+	uint32_t nameId;
+};
+
+static IntentionType* FindIntentionType(void* vtable);
+
+static void SetEntityIntention(NextBotIntention* intention)
+{
+	IntentionType* type = FindIntentionType(*reinterpret_cast<void**>(intention));
+	g_pActionsManager->SetEntityIntention(intention->entity, type != NULL ? type->nameId : ActionsNames::INVALID_NAME_ID);
+}
+
+static IntentionType s_intentionTypes[] =
+{
+	{ "SurvivorIntention", "SurvivorIntention::Reset", true },
+	{ "HunterIntention", "HunterIntention::Reset", false },
+	{ "BoomerIntention", "BoomerIntention::Reset", false },
+	{ "TankIntention", "TankIntention::Reset", false },
+	{ "InfectedIntention", "InfectedIntention::Reset", false },
+	{ "WitchIntention", "WitchIntention::Reset", false },
+	{ "SmokerIntention", "SmokerIntention::Reset", false },
+
+	#if SOURCE_ENGINE == SE_LEFT4DEAD2
+		{ "ChargerIntention", "ChargerIntention::Reset", false },
+		{ "JockeyIntention", "JockeyIntention::Reset", false },
+		{ "SpitterIntention", "SpitterIntention::Reset", false },
+	#endif
+};
+
 void OnIntentionReset()
 {
 	NextBotIntention* pIntention = META_IFACEPTR(NextBotIntention);
+
+	/* Player bots keep their entity when they respawn as another class */
+	g_pActionsManager->SetEntityIgnored(pIntention->entity, false);
+	SetEntityIntention(pIntention);
+
 	ActionProcessor processor(pIntention->entity, pIntention->GetAction());
 }
 
@@ -29,36 +78,159 @@ void OnSurviovrIntentionReset()
 	Action<void>* action = reinterpret_cast<Action<void>*>(pIntention->behavior->FirstContainedResponder());
 	Action<void>* subaction = reinterpret_cast<Action<void>*>(pIntention->subehavior->FirstContainedResponder());
 
+	g_pActionsManager->SetEntityIgnored(pIntention->entity, false);
+	SetEntityIntention(pIntention);
+
 	ActionProcessor processor(pIntention->entity, action);
 	ActionProcessor subprocessor(pIntention->entity, subaction);
 }
 
-void HookIntention(IGameConfig* cfg, const char* name, fastdelegate::FastDelegate<void> fastDelegate = SH_STATIC(OnIntentionReset))
+/* Pre hook, bot is excluded before Reset creates its first action */
+void OnIgnoredIntentionReset()
 {
-	void* addr = NULL;
+	NextBotIntention* pIntention = META_IFACEPTR(NextBotIntention);
+	g_pActionsManager->SetEntityIgnored(pIntention->entity, true);
+}
+
+static IntentionTracking GetIntentionTracking(IGameConfig* cfg, const char* name)
+{
+	const char* value = cfg->GetKeyValue(name);
+
+	if (value == NULL || strcmp(value, "track") == 0)
+		return IntentionTracking::Track;
+
+	if (strcmp(value, "ignore") == 0)
+		return IntentionTracking::Ignore;
+
+	if (strcmp(value, "off") == 0)
+		return IntentionTracking::Off;
+
+	LOGERROR("Unknown tracking \"%s\" for \"%s\" (expected track, ignore or off), tracking it", value, name);
+	return IntentionTracking::Track;
+}
+
+static IntentionType* FindIntentionType(void* vtable)
+{
+	for (IntentionType& type : s_intentionTypes)
+	{
+		if (type.vtable != NULL && type.vtable == vtable)
+			return &type;
+	}
+
+	return NULL;
+}
+
+void HookIntention(IntentionType& type)
+{
+	void* addr = type.vtable;
+
+	if (addr == NULL)
+	{
+		LOGERROR("Failed to find address for \"%s\" key. Check your gamedata...", type.address);
+		return;
+	}
 
-	if (!cfg->GetAddress(name, &addr))
+	if (type.tracking == IntentionTracking::Ignore)
 	{
-		LOGERROR("Failed to find address for \"%s\" key. Check your gamedata...", name);
+		SH_ADD_MANUALDVPHOOK(OnIntentionReset, addr, SH_STATIC(OnIgnoredIntentionReset), false);
 		return;
 	}
-	
-	SH_ADD_MANUALDVPHOOK(OnIntentionReset, addr, fastDelegate, true);
+
+	if (type.survivor)
+	{
+		SH_ADD_MANUALDVPHOOK(OnIntentionReset, addr, SH_STATIC(OnSurviovrIntentionReset), true);
+		return;
+	}
+
+	SH_ADD_MANUALDVPHOOK(OnIntentionReset, addr, SH_STATIC(OnIntentionReset), true);
 }
 
 void CreateHooks(IGameConfig* config)
 {
-	HookIntention(config, "SurvivorIntention::Reset", SH_STATIC(OnSurviovrIntentionReset));
-	HookIntention(config, "HunterIntention::Reset");
-	HookIntention(config, "BoomerIntention::Reset");
-	HookIntention(config, "TankIntention::Reset");
-	HookIntention(config, "InfectedIntention::Reset");
-	HookIntention(config, "WitchIntention::Reset");
-	HookIntention(config, "SmokerIntention::Reset");
+	for (IntentionType& type : s_intentionTypes)
+	{
+		type.tracking = GetIntentionTracking(config, type.name);
+		type.nameId = g_pActionsNames->Intern(type.name);
 
-	#if SOURCE_ENGINE == SE_LEFT4DEAD2
-		HookIntention(config, "ChargerIntention::Reset");
-		HookIntention(config, "JockeyIntention::Reset");
-		HookIntention(config, "SpitterIntention::Reset");
-	#endif
-}
\ No newline at end of file
+		/* Resolved even for untracked types, late load tells bots apart by it */
+		if (!config->GetAddress(type.address, &type.vtable))
+			type.vtable = NULL;
+
+		if (type.tracking == IntentionTracking::Off)
+		{
+			LOG("%s is not tracked (gamedata)", type.name);
+			continue;
+		}
+
+		if (type.tracking == IntentionTracking::Ignore)
+			LOG("%s bots are ignored (gamedata)", type.name);
+
+		HookIntention(type);
+	}
+}
+
+static size_t CaptureActionTree(CBaseEntity* entity, Action<void>* action)
+{
+	if (action == NULL || g_pActionsManager->GetActionOwner(action) != -1)
+		return 0;
+
+	size_t count = 1;
+	CreateActionProcessor(entity, action);
+
+	/* Result stored by event handler, applied on next update */
+	count += CaptureActionTree(entity, action->m_eventResult.m_action);
+
+	for (Action<void>* child = action->m_child; child; child = child->m_buriedUnderMe)
+		count += CaptureActionTree(entity, child);
+
+	count += CaptureActionTree(entity, action->m_buriedUnderMe);
+	count += CaptureActionTree(entity, action->m_coveringMe);
+	return count;
+}
+
+/* Late load: nextbots created before us already run their actions, walk their behaviors and capture them */
+void CaptureExistingNextBots(IGameConfig* config)
+{
+	void* addr = NULL;
+
+	if (!config->GetMemSig("TheNextBots", &addr) || addr == NULL)
+	{
+		LOGERROR("Failed to find \"TheNextBots\" signature, existing nextbots won't be captured. Check your gamedata...");
+		return;
+	}
+
+	NextBotManager& manager = reinterpret_cast<NextBotManager& (*)()>(addr)();
+	auto& bots = manager.m_botList;
+	size_t actions = 0, count = 0;
+
+	for (int i = bots.Head(); i != bots.InvalidIndex(); i = bots.Next(i))
+	{
+		NextBotIntention* intention = bots[i]->GetIntentionInterface();
+
+		if (intention == NULL || intention->behavior == NULL)
+			continue;
+
+		/* Unknown intention types are captured like before */
+		IntentionType* type = FindIntentionType(*reinterpret_cast<void**>(intention));
+
+		if (type && type->tracking == IntentionTracking::Off)
+			continue;
+
+		if (type && type->tracking == IntentionTracking::Ignore)
+		{
+			g_pActionsManager->SetEntityIgnored(intention->entity, true);
+			continue;
+		}
+
+		SetEntityIntention(intention);
+		actions += CaptureActionTree(intention->entity, intention->GetAction());
+
+		/* Only survivor intention has sub behavior */
+		if (type && type->survivor && intention->subehavior)
+			actions += CaptureActionTree(intention->entity, intention->GetSubAction());
+
+		count++;
+	}
+
+	LOG("Late load: captured %i actions of %i nextbots", actions, count);
+}
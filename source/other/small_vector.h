@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <cstdlib>
+#include <type_traits>
+
+/*
+ * Vector with inline storage for the first N elements.
+ * Only meant for trivially copyable types (pointers, handles), elements are moved with memcpy.
+ */
+template<typename T, size_t N>
+class SmallVector
+{
+	static_assert(std::is_trivially_copyable<T>::value, "SmallVector only supports trivially copyable types");
+
+public:
+	using iterator = T*;
+	using const_iterator = const T*;
+
+	SmallVector() : m_data(m_inline), m_size(0), m_capacity(N)
+	{
+	}
+
+	SmallVector(const SmallVector& other) : SmallVector()
+	{
+		*this = other;
+	}
+
+	~SmallVector()
+	{
+		if (IsSpilled())
+			free(m_data);
+	}
+
+	SmallVector& operator=(const SmallVector& other)
+	{
+		if (this == &other)
+			return *this;
+
+		assign(other.m_data, other.m_size);
+		return *this;
+	}
+
+	/* Stays empty if storage can't be allocated */
+	bool assign(const T* data, size_t count)
+	{
+		clear();
+
+		if (!reserve(count))
+			return false;
+
+		memcpy(m_data, data, count * sizeof(T));
+		m_size = count;
+		return true;
+	}
+
+	/* Value is not added if storage can't grow */
+	bool push_back(const T& value)
+	{
+		if (m_size == m_capacity && !reserve(m_capacity * 2))
+			return false;
+
+		m_data[m_size++] = value;
+		return true;
+	}
+
+	iterator erase(iterator iter)
+	{
+		size_t index = iter - m_data;
+		memmove(m_data + index, m_data + index + 1, (m_size - index - 1) * sizeof(T));
+		m_size--;
+		return m_data + index;
+	}
+
+	bool reserve(size_t capacity)
+	{
+		if (capacity <= m_capacity)
+			return true;
+
+		T* data = static_cast<T*>(malloc(capacity * sizeof(T)));
+
+		if (data == NULL)
+			return false;
+
+		memcpy(data, m_data, m_size * sizeof(T));
+
+		if (IsSpilled())
+			free(m_data);
+
+		m_data = data;
+		m_capacity = capacity;
+		return true;
+	}
+
+	void clear() noexcept
+	{
+		m_size = 0;
+	}
+
+	/* Releases heap storage and goes back to inline buffer */
+	void reset() noexcept
+	{
+		if (IsSpilled())
+			free(m_data);
+
+		m_data = m_inline;
+		m_size = 0;
+		m_capacity = N;
+	}
+
+	T& operator[](size_t i) noexcept { return m_data[i]; }
+	const T& operator[](size_t i) const noexcept { return m_data[i]; }
+
+	iterator begin() noexcept { return m_data; }
+	iterator end() noexcept { return m_data + m_size; }
+	const_iterator begin() const noexcept { return m_data; }
+	const_iterator end() const noexcept { return m_data + m_size; }
+
+	size_t size() const noexcept { return m_size; }
+	size_t capacity() const noexcept { return m_capacity; }
+	bool empty() const noexcept { return m_size == 0; }
+
+	bool IsSpilled() const noexcept { return m_data != m_inline; }
+
+	/* Bytes allocated outside of the object itself */
+	size_t GetHeapUsage() const noexcept { return IsSpilled() ? m_capacity * sizeof(T) : 0; }
+
+private:
+	T* m_data;
+	size_t m_size;
+	size_t m_capacity;
+	T m_inline[N];
+};
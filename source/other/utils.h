@@ -10,6 +10,7 @@
 
 // #define NOLOGS
 // #define NO_RUNTIME_VALIDATION
+// #define NO_PROFILER
 
 #ifndef __linux__
 	MEM_INTERFACE IMemAlloc* g_pMemAlloc;
@@ -32,16 +33,20 @@
 #endif
 
 #ifndef NOLOGS
-	#define LOG(fmt, ...) g_pSM->LogMessage(myself, fmt, ##__VA_ARGS__)
+	/* Goes to SourceMod logs or background writer of ActionsLog (ext_actions_log_async), game thread only */
+	void ActionsLogMessage(const char* fmt, ...);
+
+	#define LOG(fmt, ...) ActionsLogMessage(fmt, ##__VA_ARGS__)
 	#define LOGERROR(fmt, ...) g_pSM->LogError(myself, fmt, ##__VA_ARGS__)
 	#ifdef _DEBUG
-		#define LOGDEBUG(fmt, ...) g_pSM->LogMessage(myself, fmt, ##__VA_ARGS__)
+		#define LOGDEBUG(fmt, ...) ActionsLogMessage(fmt, ##__VA_ARGS__)
 	#else
 		#define LOGDEBUG(fmt, ...) ((void)0)
 	#endif
 #else
 	#define LOG(fmt, ...) ((void)0)
 	#define LOGERROR(fmt, ...) ((void)0)
+	#define LOGDEBUG(fmt, ...) ((void)0)
 #endif
 
 #if SOURCE_ENGINE == SE_LEFT4DEAD2
@@ -3,14 +3,21 @@
 #include "actions_manager.h"
 #include "actions_processor.h"
 #include "actions_custom.h"
+#include "actions_profiler.h"
+#include "actions_recorder.h"
+#include "actions_batch.h"
+#include "actions_rules.h"
+#include "actions_log.h"
 #include "actions_commands.h"
 
 #include "actions_natives.h"
 #include "actions_processors_natives.h"
 #include "actions_custom_natives.h"
+#include "actions_args_natives.h"
 
 #include "hooks.h"
 #include <compat_wrappers.h>
+#include <filesystem.h>
 
 #pragma comment(lib, "legacy_stdio_definitions.lib")
 
@@ -20,6 +27,7 @@ SMEXT_LINK(&g_BehaviorActions);
 IGameConfig* g_pGameConf;
 CGlobalVars *gpGlobals;
 ICvar *icvar;
+IBaseFileSystem* basefilesystem;
 
 bool CExtBehaviorActions::SDK_OnLoad(char* error, size_t maxlen, bool late)
 {
@@ -37,6 +45,11 @@ bool CExtBehaviorActions::SDK_OnLoad(char* error, size_t maxlen, bool late)
 	sharesys->AddNatives(myself, g_ActionNatives);
 	sharesys->AddNatives(myself, g_ActionProcessorNatives);
 	sharesys->AddNatives(myself, g_ActionCustomNatives);
+	sharesys->AddNatives(myself, g_ActionArgNatives);
+
+	smutils->AddGameFrameHook(&ActionsBatch::OnGameFrame);
+
+	m_late = late;
 	return true;
 }
 
@@ -44,23 +57,44 @@ void CExtBehaviorActions::SDK_OnAllLoaded()
 {
 	ReconfigureHooks();
 	CreateHooks(g_pGameConf);
+
+	/* Rules resolve handler offsets, so they are loaded once hooks are configured */
+	g_pActionsRules->Load();
+
+	if (m_late)
+		CaptureExistingNextBots(g_pGameConf);
 }
 
 void CExtBehaviorActions::SDK_OnUnload()
 {
+	smutils->RemoveGameFrameHook(&ActionsBatch::OnGameFrame);
 	plsys->RemovePluginsListener(this);
 	gameconfs->CloseGameConfigFile(g_pGameConf);
+
+	/* Flush queued messages before the module goes away */
+	g_pActionsLog->Stop();
+}
+
+void CExtBehaviorActions::OnPluginLoaded(IPlugin* plugin)
+{
+	/* Plugin functions are already added to global forwards */
+	g_pActionsManager->UpdateChangeHooks();
 }
 
 void CExtBehaviorActions::OnPluginUnloaded(IPlugin* plugin)
 {
 	g_pActionsPropagatePre->RemoveListeners(plugin->GetBaseContext());
 	g_pActionsPropagatePost->RemoveListeners(plugin->GetBaseContext());
+	g_pActionsManager->RemoveWatchers(plugin->GetBaseContext());
+	g_pActionsBatch->RemoveListeners(plugin->GetBaseContext());
+	g_pActionsProfiler->OnPluginUnloaded(plugin->GetRuntime());
+	g_pActionsRecorder->OnPluginUnloaded(plugin->GetRuntime());
 }
 
 bool CExtBehaviorActions::SDK_OnMetamodLoad(ISmmAPI *ismm, char *error, size_t maxlen, bool late)
 {
 	GET_V_IFACE_CURRENT(GetEngineFactory, icvar, ICvar, CVAR_INTERFACE_VERSION);
+	GET_V_IFACE_CURRENT(GetFileSystemFactory, basefilesystem, IBaseFileSystem, BASEFILESYSTEM_INTERFACE_VERSION);
 	g_pCVar = icvar;
 	gpGlobals = ismm->GetCGlobals();
 	CONVAR_REGISTER(this);